@@ -8,33 +8,71 @@ CONFIG(release, debug|release) {
 
 QT += core concurrent xml sql network gui widgets
 
+tracing {
+    DEFINES += QMEDIATHEKVIEW_TRACING
+}
+
 CONFIG += link_pkgconfig
-PKGCONFIG += liblzma
+PKGCONFIG += liblzma zlib
 
 TARGET = QMediathekView
 TEMPLATE = app
 
 SOURCES += \
     settings.cpp \
+    timings.cpp \
+    trace.cpp \
+    arena.cpp \
     parser.cpp \
+    searchkey.cpp \
+    compression.cpp \
     database.cpp \
+    updater.cpp \
+    catalogue.cpp \
+    channelindex.cpp \
+    completionindex.cpp \
+    completionmodel.cpp \
     model.cpp \
+    decompressor.cpp \
     miscellaneous.cpp \
     mainwindow.cpp \
-    downloaddialog.cpp \
+    transfer.cpp \
+    download.cpp \
+    hlsdownload.cpp \
+    tokenbucket.cpp \
+    downloadmanager.cpp \
+    server.cpp \
     settingsdialog.cpp \
+    commandline.cpp \
     application.cpp
 
 HEADERS += \
     settings.h \
+    timings.h \
+    trace.h \
     schema.h \
+    arena.h \
     parser.h \
+    searchkey.h \
+    compression.h \
     database.h \
+    updater.h \
+    catalogue.h \
+    channelindex.h \
+    completionindex.h \
+    completionmodel.h \
     model.h \
+    decompressor.h \
     miscellaneous.h \
     mainwindow.h \
-    downloaddialog.h \
+    transfer.h \
+    download.h \
+    hlsdownload.h \
+    tokenbucket.h \
+    downloadmanager.h \
+    server.h \
     settingsdialog.h \
+    commandline.h \
     application.h
 
 target.path = /usr/bin
@@ -21,26 +21,28 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "application.h"
 
-#include <memory>
-#include <random>
-
 #include <QDesktopServices>
-#include <QDomDocument>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMessageBox>
 #include <QProcess>
+#include <QRegularExpression>
+#include <QTextStream>
 #include <QTimer>
 #include <QUrl>
 
-#include <lzma.h>
-
 #include "settings.h"
+#include "timings.h"
 #include "database.h"
+#include "updater.h"
 #include "model.h"
 #include "mainwindow.h"
-#include "downloaddialog.h"
+#include "downloadmanager.h"
+#include "hlsdownload.h"
+#include "commandline.h"
+#include "server.h"
+#include "trace.h"
 
 namespace QMediathekView
 {
@@ -50,58 +52,71 @@ namespace
 
 const auto projectName = QStringLiteral("QMediathekView");
 
-namespace Tags
-{
-
-const auto root = QStringLiteral("Mediathek");
-const auto server = QStringLiteral("Server");
-const auto url = QStringLiteral("URL");
-
-} // Tags
+// Started as early as possible to approximate the start of the process.
+QElapsedTimer startupTimer;
 
-QString randomItem(const QStringList& list)
+bool measuresStartup()
 {
-    std::random_device device;
-    std::default_random_engine generator(device());
-    std::uniform_int_distribution<> distribution(0, list.size() - 1);
-
-    return list.at(distribution(generator));
+    return qEnvironmentVariableIsSet("QMEDIATHEKVIEW_STARTUP");
 }
 
-class Decompressor
+// Reports the time until the first frame was painted and until the database was opened, then quits.
+class StartupProbe : public QObject
 {
 public:
-    Decompressor()
-        : m_stream(LZMA_STREAM_INIT)
+    StartupProbe(QWidget* window, Database* database, QObject* parent)
+        : QObject(parent)
+        , m_firstFrame(-1)
+        , m_opened(-1)
     {
-        Q_UNUSED(lzma_stream_decoder(&m_stream, UINT64_MAX, LZMA_TELL_NO_CHECK));
+        window->installEventFilter(this);
+
+        connect(database, &Database::opened, this, [this]()
+        {
+            m_opened = startupTimer.nsecsElapsed();
+
+            report();
+        });
     }
 
-    void appendData(const QByteArray& data)
+    bool eventFilter(QObject* object, QEvent* event) override
     {
-        m_stream.next_in = reinterpret_cast< const std::uint8_t* >(data.constData());
-        m_stream.avail_in = data.size();
-
-        for (lzma_ret result = LZMA_OK; result == LZMA_OK;)
+        if (event->type() == QEvent::Paint && m_firstFrame < 0)
         {
-            m_stream.next_out = m_buffer;
-            m_stream.avail_out = sizeof(m_buffer);
+            object->removeEventFilter(this);
 
-            result = lzma_code(&m_stream, LZMA_RUN);
+            // The frame is considered painted once the paint event has been processed.
+            QTimer::singleShot(0, this, [this]()
+            {
+                m_firstFrame = startupTimer.nsecsElapsed();
 
-            m_data.append(reinterpret_cast< const char* >(m_buffer), sizeof(m_buffer) - m_stream.avail_out);
+                report();
+            });
         }
-    }
 
-    const QByteArray& data() const
-    {
-        return m_data;
+        return false;
     }
 
 private:
-    lzma_stream m_stream;
-    std::uint8_t m_buffer[64 * 1024];
-    QByteArray m_data;
+    qint64 m_firstFrame;
+    qint64 m_opened;
+
+    void report()
+    {
+        if (m_firstFrame < 0 || m_opened < 0)
+        {
+            return;
+        }
+
+        QJsonObject object;
+
+        object.insert(QStringLiteral("firstFrameMilliseconds"), m_firstFrame / 1000.0 / 1000.0);
+        object.insert(QStringLiteral("openedMilliseconds"), m_opened / 1000.0 / 1000.0);
+
+        QTextStream(stdout) << QJsonDocument(object).toJson(QJsonDocument::Compact) << endl;
+
+        QCoreApplication::quit();
+    }
 
 };
 
@@ -110,32 +125,63 @@ private:
 Application::Application(int& argc, char** argv)
     : QApplication(argc, argv)
     , m_settings(new Settings(this))
-    , m_database(new Database(*m_settings, this))
+    , m_timings(new Timings(*m_settings, this))
+    , m_database(new Database(*m_settings, *m_timings, this))
+    , m_updater(new Updater(*m_settings, *m_timings, *m_database, this))
     , m_model(new Model(*m_database, this))
-    , m_networkManager(new QNetworkAccessManager(this))
-    , m_mainWindow(new MainWindow(*m_settings, *m_model, *this))
+    , m_downloadManager(new DownloadManager(*m_settings, this))
+    , m_mainWindow(new MainWindow(*m_settings, *m_model, *m_downloadManager, *this))
+    , m_server(nullptr)
 {
+    connect(m_database, &Database::opened, m_model, &Model::update);
+    connect(m_database, &Database::opened, m_mainWindow, &MainWindow::showOpenedDatabase);
     connect(m_database, &Database::updated, m_model, &Model::update);
 
-    connect(m_database, &Database::updated, this, &Application::completedDatabaseUpdate);
-    connect(m_database, &Database::failedToUpdate, this, &Application::failedToUpdateDatabase);
+    connect(m_updater, &Updater::startedMirrorsUpdate, m_mainWindow, &MainWindow::showStartedMirrorsUpdate);
+    connect(m_updater, &Updater::completedMirrorsUpdate, m_mainWindow, &MainWindow::showCompletedMirrorsUpdate);
+    connect(m_updater, &Updater::failedToUpdateMirrors, m_mainWindow, &MainWindow::showMirrorsUpdateFailure);
 
-    connect(this, &Application::startedMirrorsUpdate, m_mainWindow, &MainWindow::showStartedMirrorsUpdate);
-    connect(this, &Application::completedMirrorsUpdate, m_mainWindow, &MainWindow::showCompletedMirrorsUpdate);
-    connect(this, &Application::failedToUpdateMirrors, m_mainWindow, &MainWindow::showMirrorsUpdateFailure);
+    connect(m_updater, &Updater::startedDatabaseUpdate, m_mainWindow, &MainWindow::showStartedDatabaseUpdate);
+    connect(m_updater, &Updater::completedDatabaseUpdate, m_mainWindow, &MainWindow::showCompletedDatabaseUpdate);
+    connect(m_updater, &Updater::failedToUpdateDatabase, m_mainWindow, &MainWindow::showDatabaseUpdateFailure);
+
+    if (const auto port = m_settings->serverPort())
+    {
+        m_server = new Server(*m_database, this);
 
-    connect(this, &Application::startedDatabaseUpdate, m_mainWindow, &MainWindow::showStartedDatabaseUpdate);
-    connect(this, &Application::completedDatabaseUpdate, m_mainWindow, &MainWindow::showCompletedDatabaseUpdate);
-    connect(this, &Application::failedToUpdateDatabase, m_mainWindow, &MainWindow::showDatabaseUpdateFailure);
+        if (!m_server->listen(port))
+        {
+            qWarning("Failed to start query service: %s", qPrintable(m_server->errorString()));
+        }
+    }
+
+    if (measuresStartup())
+    {
+        new StartupProbe(m_mainWindow, m_database, this);
+    }
+
+    // The window is shown while the database is still being opened.
+    m_database->open();
 }
 
 Application::~Application()
 {
+#ifdef QMEDIATHEKVIEW_TRACING
+
+    if (qEnvironmentVariableIsSet("QMEDIATHEKVIEW_TRACE"))
+    {
+        Trace::dump(Trace::defaultFileName());
+    }
+
+#endif // QMEDIATHEKVIEW_TRACING
 }
 
 int Application::exec()
 {
-    QTimer::singleShot(0, this, &Application::checkUpdateMirrors);
+    if (!measuresStartup())
+    {
+        QTimer::singleShot(0, m_updater, &Updater::checkUpdateMirrors);
+    }
 
     m_mainWindow->setAttribute(Qt::WA_DeleteOnClose);
     m_mainWindow->show();
@@ -145,7 +191,7 @@ int Application::exec()
 
 void Application::playPreferred(const QModelIndex& index) const
 {
-    startPlay(preferredUrl(index));
+    startPlay(urlOf(index, preferredUrl(index)));
 }
 
 void Application::playDefault(const QModelIndex& index) const
@@ -165,135 +211,80 @@ void Application::playLarge(const QModelIndex& index) const
 
 void Application::downloadPreferred(const QModelIndex& index) const
 {
-    startDownload(m_model->title(index), preferredUrl(index));
+    startDownload(index, preferredUrl(index));
 }
 
 void Application::downloadDefault(const QModelIndex& index) const
 {
-    startDownload(m_model->title(index), m_model->url(index));
+    startDownload(index, Url::Default);
 }
 
 void Application::downloadSmall(const QModelIndex& index) const
 {
-    startDownload(m_model->title(index), m_model->urlSmall(index));
+    startDownload(index, Url::Small);
 }
 
 void Application::downloadLarge(const QModelIndex& index) const
 {
-    startDownload(m_model->title(index), m_model->urlLarge(index));
+    startDownload(index, Url::Large);
 }
 
-void Application::checkUpdateMirrors()
+void Application::updateDatabase()
 {
-    const auto updateAfter = m_settings->mirrorsUpdateAfterDays();
-    const auto updatedOn = m_settings->mirrorsUpdatedOn();
-    const auto updatedBefore = updatedOn.daysTo(QDateTime::currentDateTime());
-
-    if (!updatedOn.isValid() || updateAfter < updatedBefore)
-    {
-        updateMirrors();
-    }
-    else
-    {
-        checkUpdateDatabase();
-    }
+    m_updater->updateDatabase();
 }
 
-void Application::checkUpdateDatabase()
+Url Application::preferredUrl(const QModelIndex& index) const
 {
-    const auto updateAfter = m_settings->databaseUpdateAfterHours();
-    const auto updatedOn = m_settings->databaseUpdatedOn();
-    const auto updatedBefore = updatedOn.secsTo(QDateTime::currentDateTime()) / 60 / 60;
+    auto firstUrl = Url::Default;
+    auto secondUrl = Url::Small;
+    auto thirdUrl = Url::Large;
 
-    if (!updatedOn.isValid() || updateAfter < updatedBefore)
+    switch (m_settings->preferredUrl())
     {
-        updateDatabase();
+    default:
+    case Url::Default:
+        break;
+    case Url::Small:
+        firstUrl = Url::Small;
+        secondUrl = Url::Default;
+        thirdUrl = Url::Large;
+        break;
+    case Url::Large:
+        firstUrl = Url::Large;
+        secondUrl = Url::Default;
+        thirdUrl = Url::Small;
+        break;
     }
-}
 
-void Application::updateMirrors()
-{
-    emit startedMirrorsUpdate();
-
-    downloadMirrors(m_settings->fullListUrl(), [this](const QStringList& mirrors)
+    if (urlOf(index, firstUrl).isEmpty())
     {
-        m_settings->setFullListMirrors(mirrors);
-
-        downloadMirrors(m_settings->partialListUrl(), [this](const QStringList& mirrors)
+        if (!urlOf(index, secondUrl).isEmpty())
         {
-            m_settings->setPartialListMirrors(mirrors);
-            m_settings->setMirrorsUpdatedOn();
-
-            emit completedMirrorsUpdate();
-
-            QTimer::singleShot(0, this, &Application::checkUpdateDatabase);
-        });
-    });
-}
-
-void Application::updateDatabase()
-{
-    emit startedDatabaseUpdate();
-
-    const auto updatedOn = m_settings->databaseUpdatedOn();
-    const auto fullUpdateOn = QDateTime(QDate::currentDate(), QTime(9, 0));
-
-    if (!updatedOn.isValid() || updatedOn < fullUpdateOn)
-    {
-        const auto url = randomItem(m_settings->fullListMirrors());
+            return secondUrl;
+        }
 
-        downloadDatabase(url, [this](const QByteArray& data)
+        if (!urlOf(index, thirdUrl).isEmpty())
         {
-            m_database->fullUpdate(data);
-        });
+            return thirdUrl;
+        }
     }
-    else
-    {
-        const auto url = randomItem(m_settings->partialListMirrors());
 
-        downloadDatabase(url, [this](const QByteArray& data)
-        {
-            m_database->partialUpdate(data);
-        });
-    }
+    return firstUrl;
 }
 
-QString Application::preferredUrl(const QModelIndex& index) const
+QString Application::urlOf(const QModelIndex& index, const Url variant) const
 {
-    auto firstUrl = &Model::url;
-    auto secondUrl = &Model::urlSmall;
-    auto thirdUrl = &Model::urlLarge;
-
-    switch (m_settings->preferredUrl())
+    switch (variant)
     {
     default:
     case Url::Default:
-        break;
+        return m_model->url(index);
     case Url::Small:
-        firstUrl = &Model::urlSmall;
-        secondUrl = &Model::url;
-        thirdUrl = &Model::urlLarge;
-        break;
+        return m_model->urlSmall(index);
     case Url::Large:
-        firstUrl = &Model::urlLarge;
-        secondUrl = &Model::url;
-        thirdUrl = &Model::urlSmall;
-        break;
-    }
-
-    auto url = (m_model->*firstUrl)(index);
-
-    if (url.isEmpty())
-    {
-        url = (m_model->*secondUrl)(index);
+        return m_model->urlLarge(index);
     }
-
-    if (url.isEmpty())
-    {
-        url = (m_model->*thirdUrl)(index);
-    }
-
-    return url;
 }
 
 void Application::startPlay(const QString& url) const
@@ -313,8 +304,11 @@ void Application::startPlay(const QString& url) const
     }
 }
 
-void Application::startDownload(const QString& title, const QString& url) const
+void Application::startDownload(const QModelIndex& index, const Url variant) const
 {
+    const auto title = m_model->title(index);
+    const auto url = urlOf(index, variant);
+
     const auto command = m_settings->downloadCommand();
 
     if (!command.isEmpty())
@@ -323,116 +317,60 @@ void Application::startDownload(const QString& title, const QString& url) const
         {
             QMessageBox::critical(m_mainWindow, tr("Critical"), tr("Failed to execute download command."));
         }
-    }
-    else
-    {
-        const auto dialog = new DownloadDialog(
-            *m_settings, m_networkManager,
-            title, url);
 
-        dialog->setAttribute(Qt::WA_DeleteOnClose);
-        dialog->show();
+        return;
     }
-}
 
-template< typename Consumer >
-void Application::downloadMirrors(const QString& url, const Consumer& consumer)
-{
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::UserAgentHeader, m_settings->userAgent());
+    const auto key = m_model->key(index) + char(variant);
 
-    const auto reply = m_networkManager->get(request);
+    QString filePath;
 
-    connect(reply, &QNetworkReply::finished, [this, consumer, reply]()
+    switch (m_downloadManager->check(key, filePath))
     {
-        reply->deleteLater();
-
-        if (reply->error())
-        {
-            emit failedToUpdateMirrors(reply->errorString());
-            return;
-        }
-
-        QStringList mirrors;
-
-        {
-            QDomDocument document;
-            document.setContent(reply);
-
-            const auto root = document.documentElement();
-            if (root.tagName() != Tags::root)
-            {
-                emit failedToUpdateMirrors(tr("Received a malformed mirror list."));
-                return;
-            }
-
-            auto server = root.firstChildElement(Tags::server);
-
-            while (!server.isNull())
-            {
-                const auto url = server.firstChildElement(Tags::url).text();
-
-                if (!url.isEmpty())
-                {
-                    mirrors.append(url);
-                }
-
-                server = server.nextSiblingElement(Tags::server);
-            }
-        }
-
-        if (mirrors.isEmpty())
+    default:
+    case DownloadManager::NotDownloaded:
+        break;
+    case DownloadManager::Downloaded:
+        if (QMessageBox::question(m_mainWindow, tr("Question"), tr("This show has already been downloaded to '%1'. Download it again?").arg(filePath)) != QMessageBox::Yes)
         {
-            emit failedToUpdateMirrors(tr("Received an empty mirror list."));
             return;
         }
-
-        consumer(mirrors);
-    });
-}
-
-template< typename Consumer >
-void Application::downloadDatabase(const QString& url, const Consumer& consumer)
-{
-    const auto decompressor = std::make_shared< Decompressor >();
-
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::UserAgentHeader, m_settings->userAgent());
-
-    const auto reply = m_networkManager->get(request);
-
-    connect(reply, &QNetworkReply::readyRead, [this, reply, decompressor]()
-    {
-        if (reply->error())
+        break;
+    case DownloadManager::Corrupt:
+        if (QMessageBox::warning(m_mainWindow, tr("Warning"), tr("The previous download of this show to '%1' is incomplete or corrupt. Download it again?").arg(filePath), QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
         {
             return;
         }
+        break;
+    }
 
-        decompressor->appendData(reply->readAll());
-    });
+    auto fileName = QUrl(url).fileName();
 
-    connect(reply, &QNetworkReply::finished, [this, consumer, reply, decompressor]()
+    // Streams are named after the show as the playlist's name is usually meaningless.
+    if (HlsDownload::isPlaylist(QUrl(url)))
     {
-        reply->deleteLater();
-
-        if (reply->error())
-        {
-            emit failedToUpdateDatabase(reply->errorString());
-            return;
-        }
-
-        decompressor->appendData(reply->readAll());
+        fileName = title;
+        fileName.replace(QRegularExpression(QStringLiteral("[\\\\/:*?\"<>|]")), QStringLiteral("_"));
+        fileName += QStringLiteral(".ts");
+    }
 
-        consumer(decompressor->data());
-    });
+    m_downloadManager->enqueue(title, url, m_settings->downloadFolder().absoluteFilePath(fileName), key);
 }
 
 } // QMediathekView
 
 int main(int argc, char** argv)
 {
+    QMediathekView::startupTimer.start();
+
     QApplication::setOrganizationName(QMediathekView::projectName);
     QApplication::setApplicationName(QMediathekView::projectName);
 
+    // Updates and searches requested on the command line are run without a display.
+    if (QMediathekView::CommandLine::isRequested(argc, argv))
+    {
+        return QMediathekView::CommandLine(argc, argv).exec();
+    }
+
     return QMediathekView::Application(argc, argv).exec();
 }
@@ -24,15 +24,19 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QApplication>
 
-class QNetworkAccessManager;
+#include "schema.h"
 
 namespace QMediathekView
 {
 
 class Settings;
+class Timings;
 class Database;
+class Updater;
 class Model;
+class DownloadManager;
 class MainWindow;
+class Server;
 
 class Application : public QApplication
 {
@@ -43,15 +47,6 @@ public:
     Application(int& argc, char** argv);
     ~Application();
 
-signals:
-    void startedMirrorsUpdate();
-    void completedMirrorsUpdate();
-    void failedToUpdateMirrors(const QString& error);
-
-    void startedDatabaseUpdate();
-    void completedDatabaseUpdate();
-    void failedToUpdateDatabase(const QString& error);
-
 public:
     int exec();
 
@@ -65,33 +60,28 @@ public:
     void downloadSmall(const QModelIndex& index) const;
     void downloadLarge(const QModelIndex& index) const;
 
-    void checkUpdateMirrors();
-    void checkUpdateDatabase();
-
-    void updateMirrors();
     void updateDatabase();
 
 private:
-    QString preferredUrl(const QModelIndex& index) const;
+    Url preferredUrl(const QModelIndex& index) const;
+    QString urlOf(const QModelIndex& index, const Url variant) const;
 
     void startPlay(const QString& url) const;
-    void startDownload(const QString& title, const QString& url) const;
-
-    template< typename Consumer >
-    void downloadMirrors(const QString& url, const Consumer& consumer);
-
-    template< typename Consumer >
-    void downloadDatabase(const QString& url, const Consumer& consumer);
+    void startDownload(const QModelIndex& index, const Url variant) const;
 
 private:
     Settings* m_settings;
+    Timings* m_timings;
     Database* m_database;
+    Updater* m_updater;
     Model* m_model;
 
-    QNetworkAccessManager* m_networkManager;
+    DownloadManager* m_downloadManager;
 
     MainWindow* m_mainWindow;
 
+    Server* m_server;
+
 };
 
 } // QMediathekView
@@ -0,0 +1,99 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "arena.h"
+
+#include <cstring>
+
+namespace QMediathekView
+{
+
+Arena::Arena(const std::size_t blockSize)
+    : m_blockSize(blockSize)
+    , m_block(0)
+    , m_offset(0)
+    , m_allocations(0)
+{
+}
+
+Arena::~Arena()
+{
+}
+
+char* Arena::allocate(const std::size_t size)
+{
+    if (size > m_blockSize)
+    {
+        m_largeBlocks.emplace_back(new char[size]);
+        ++m_allocations;
+
+        return m_largeBlocks.back().get();
+    }
+
+    if (m_blocks.empty() || m_offset + size > m_blockSize)
+    {
+        nextBlock();
+    }
+
+    const auto data = m_blocks[m_block].get() + m_offset;
+    m_offset += size;
+
+    return data;
+}
+
+Text Arena::copy(const char* data, const int size)
+{
+    const auto copy = allocate(size);
+    std::memcpy(copy, data, size);
+
+    return { copy, size };
+}
+
+void Arena::reset()
+{
+    m_block = 0;
+    m_offset = 0;
+
+    m_largeBlocks.clear();
+}
+
+std::size_t Arena::allocations() const
+{
+    return m_allocations;
+}
+
+void Arena::nextBlock()
+{
+    if (!m_blocks.empty())
+    {
+        ++m_block;
+    }
+
+    if (m_block == m_blocks.size())
+    {
+        m_blocks.emplace_back(new char[m_blockSize]);
+        ++m_allocations;
+    }
+
+    m_offset = 0;
+}
+
+} // QMediathekView
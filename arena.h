@@ -0,0 +1,94 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+namespace QMediathekView
+{
+
+struct Text
+{
+    Text()
+        : data(nullptr)
+        , size(0)
+    {
+    }
+
+    Text(const char* data, const int size)
+        : data(data)
+        , size(size)
+    {
+    }
+
+    const char* data;
+    int size;
+
+    bool isEmpty() const
+    {
+        return size == 0;
+    }
+
+    QString toString() const
+    {
+        return QString::fromUtf8(data, size);
+    }
+
+};
+
+class Arena
+{
+public:
+    explicit Arena(const std::size_t blockSize = 1024 * 1024);
+    ~Arena();
+
+    char* allocate(const std::size_t size);
+    Text copy(const char* data, const int size);
+
+    void reset();
+
+    std::size_t allocations() const;
+
+private:
+    Q_DISABLE_COPY(Arena)
+
+    const std::size_t m_blockSize;
+
+    std::vector< std::unique_ptr< char[] > > m_blocks;
+    std::size_t m_block;
+    std::size_t m_offset;
+
+    std::vector< std::unique_ptr< char[] > > m_largeBlocks;
+
+    std::size_t m_allocations;
+
+    void nextBlock();
+
+};
+
+} // QMediathekView
+
+#endif // ARENA_H
@@ -0,0 +1,896 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include "settings.h"
+#include "timings.h"
+#include "parser.h"
+#include "database.h"
+#include "completionindex.h"
+#include "model.h"
+#include "decompressor.h"
+#include "trace.h"
+
+#include "generator.h"
+
+namespace
+{
+
+std::atomic< quint64 > allocationCount(0);
+
+} // anonymous
+
+#ifdef __GLIBC__
+
+// Interpose the C allocator so that the allocations made by Qt's containers are counted as well.
+extern "C"
+{
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* data, std::size_t size);
+
+void* malloc(std::size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* data, std::size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    return __libc_realloc(data, size);
+}
+
+} // extern "C"
+
+#endif // __GLIBC__
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto defaultShowCount = 100 * 1000;
+constexpr auto defaultIterations = 5;
+constexpr auto defaultBudget = 250.0;
+
+constexpr auto scrolledRows = 10 * 1000;
+
+class Results
+{
+public:
+    template< typename Function >
+    void run(const QString& name, const int iterations, Function function)
+    {
+        QVector< qint64 > nanoseconds;
+        nanoseconds.reserve(iterations);
+
+        quint64 allocations = 0;
+
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            const auto allocationsBefore = allocationCount.load();
+
+            QElapsedTimer timer;
+            timer.start();
+
+            function();
+
+            nanoseconds.append(timer.nsecsElapsed());
+
+            allocations += allocationCount.load() - allocationsBefore;
+        }
+
+        std::sort(nanoseconds.begin(), nanoseconds.end());
+
+        const auto toMilliseconds = [](const qint64 nanoseconds)
+        {
+            return nanoseconds / 1000.0 / 1000.0;
+        };
+
+        QJsonObject result;
+
+        result.insert(QStringLiteral("name"), name);
+        result.insert(QStringLiteral("iterations"), iterations);
+        result.insert(QStringLiteral("minimumMilliseconds"), toMilliseconds(nanoseconds.first()));
+        result.insert(QStringLiteral("medianMilliseconds"), toMilliseconds(nanoseconds.at(nanoseconds.size() / 2)));
+        result.insert(QStringLiteral("maximumMilliseconds"), toMilliseconds(nanoseconds.last()));
+        result.insert(QStringLiteral("allocations"), double(allocations / iterations));
+
+        m_benchmarks.append(result);
+
+        QTextStream(stderr) << name << ": " << toMilliseconds(nanoseconds.at(nanoseconds.size() / 2)) << " ms" << endl;
+    }
+
+    void insert(const QString& key, const QJsonValue& value)
+    {
+        m_properties.insert(key, value);
+    }
+
+    QByteArray toJson() const
+    {
+        auto document = m_properties;
+        document.insert(QStringLiteral("benchmarks"), m_benchmarks);
+
+        return QJsonDocument(document).toJson();
+    }
+
+private:
+    QJsonObject m_properties;
+    QJsonArray m_benchmarks;
+
+};
+
+class CountingProcessor : public Processor
+{
+public:
+    void operator()(const std::vector< ShowRecord >& shows) override
+    {
+        count += shows.size();
+    }
+
+    int count = 0;
+
+};
+
+bool runUpdate(Database& database, void (Database::*update)(const QByteArray&), const QByteArray& data)
+{
+    QEventLoop loop;
+    auto ok = false;
+
+    QObject::connect(&database, &Database::updated, &loop, [&]()
+    {
+        ok = true;
+        loop.quit();
+    });
+
+    QObject::connect(&database, &Database::failedToUpdate, &loop, &QEventLoop::quit);
+
+    (database.*update)(data);
+
+    loop.exec();
+
+    return ok;
+}
+
+const char* const sortColumnNames[] =
+{
+    "channel", "topic", "title", "date", "time", "duration"
+};
+
+struct QueryCase
+{
+    const char* name;
+    Filter filter;
+};
+
+QVector< QueryCase > queryCases()
+{
+    QVector< QueryCase > cases(9);
+
+    cases[0].name = "none";
+
+    cases[1].name = "channel";
+    cases[1].filter.channel = QStringLiteral("ZDF");
+
+    cases[2].name = "topic";
+    cases[2].filter.topic = QStringLiteral("Wetter");
+
+    cases[3].name = "title";
+    cases[3].filter.title = QStringLiteral("folge 1");
+
+    cases[4].name = "channelAndTitle";
+    cases[4].filter.channel = QStringLiteral("ARD");
+    cases[4].filter.title = QStringLiteral("Nachrichten");
+
+    // The generated shows were broadcast during the 30 days before this date.
+    cases[5].name = "lastWeek";
+    cases[5].filter.fromDate = QDate(2016, 10, 16).addDays(-7);
+
+    cases[6].name = "longerThan20Minutes";
+    cases[6].filter.minimumDuration = QTime(0, 20);
+
+    cases[7].name = "channelSet";
+    cases[7].filter.channels = QStringList({ QStringLiteral("3Sat"), QStringLiteral("ARD"), QStringLiteral("ZDF") });
+
+    // Matches the generated titles containing "Straße" only if case and diacritics are folded.
+    cases[8].name = "foldedTitle";
+    cases[8].filter.title = QStringLiteral("STRASSE");
+
+    return cases;
+}
+
+// Yields the identifiers matching each case irrespective of their order.
+QVector< QVector< quintptr > > matchQueries(const Database& database)
+{
+    QVector< QVector< quintptr > > matches;
+
+    for (const auto& queryCase : queryCases())
+    {
+        auto ids = database.query(queryCase.filter, Database::SortDate, Qt::AscendingOrder);
+        std::sort(ids.begin(), ids.end());
+
+        matches.append(ids);
+    }
+
+    return matches;
+}
+
+void runQueries(Results& results, const Database& database, const QString& engine, const int iterations)
+{
+    const auto filters = queryCases();
+
+    for (const auto& filter : filters)
+    {
+        for (int sortColumn = Database::SortChannel; sortColumn <= Database::SortDuration; ++sortColumn)
+        {
+            for (const auto sortOrder : { Qt::AscendingOrder, Qt::DescendingOrder })
+            {
+                const auto name = QStringLiteral("query/%1/%2/%3/%4")
+                                  .arg(engine, filter.name, sortColumnNames[sortColumn],
+                                       sortOrder == Qt::AscendingOrder ? QStringLiteral("ascending") : QStringLiteral("descending"));
+
+                results.run(name, iterations, [&]()
+                {
+                    database.query(filter.filter, Database::SortColumn(sortColumn), sortOrder);
+                });
+            }
+        }
+    }
+
+    results.run(QStringLiteral("channels/%1").arg(engine), iterations, [&]()
+    {
+        database.channels();
+    });
+
+    results.run(QStringLiteral("topics/%1").arg(engine), iterations, [&]()
+    {
+        database.topics(QStringLiteral("ZDF"));
+    });
+}
+
+// Checks that every sort order is served by an index instead of sorting the matching rows.
+bool checkQueryPlans(Results& results, const Database& database)
+{
+    auto ok = true;
+
+    QJsonObject plans;
+
+    for (int sortColumn = Database::SortChannel; sortColumn <= Database::SortDuration; ++sortColumn)
+    {
+        for (const auto sortOrder : { Qt::AscendingOrder, Qt::DescendingOrder })
+        {
+            const auto name = QStringLiteral("%1/%2")
+                              .arg(sortColumnNames[sortColumn],
+                                   sortOrder == Qt::AscendingOrder ? QStringLiteral("ascending") : QStringLiteral("descending"));
+
+            const auto plan = database.explainQuery(Filter(), Database::SortColumn(sortColumn), sortOrder);
+
+            if (plan.isEmpty() || plan.join(QChar('\n')).contains(QLatin1String("USE TEMP B-TREE FOR ORDER BY")))
+            {
+                qWarning("Query sorted by %s does not use an index: %s", qPrintable(name), qPrintable(plan.join(QStringLiteral("; "))));
+
+                ok = false;
+            }
+
+            plans.insert(name, QJsonArray::fromStringList(plan));
+        }
+    }
+
+    results.insert(QStringLiteral("queryPlans"), plans);
+
+    return ok;
+}
+
+struct Predicate
+{
+    const char* name;
+    void (*apply)(Filter& filter);
+
+    // The sort column whose index can also seek this predicate or -1 if no index can.
+    int sortColumn;
+};
+
+const Predicate predicates[] =
+{
+    { "channel", [](Filter& filter) { filter.channel = QStringLiteral("ZDF"); }, -1 },
+    { "topic", [](Filter& filter) { filter.topic = QStringLiteral("Wetter"); }, -1 },
+    { "title", [](Filter& filter) { filter.title = QStringLiteral("folge 1"); }, -1 },
+    { "channels", [](Filter& filter) { filter.channels = QStringList({ QStringLiteral("ARD"), QStringLiteral("ZDF") }); }, Database::SortChannel },
+    { "date", [](Filter& filter) { filter.fromDate = QDate(2016, 10, 9); }, Database::SortDate },
+    { "time", [](Filter& filter) { filter.fromTime = QTime(18, 0); }, Database::SortTime },
+    { "duration", [](Filter& filter) { filter.minimumDuration = QTime(0, 20); }, Database::SortDuration }
+};
+
+constexpr auto predicateCount = int(sizeof(predicates) / sizeof(predicates[0]));
+
+// A plan is worse than another if it visits the table for the entries of an index, sorts or scans the whole table where the other did not.
+int rankOf(const QStringList& plan)
+{
+    auto rank = 0;
+
+    for (const auto& detail : plan)
+    {
+        if (detail.contains(QLatin1String("USE TEMP B-TREE")))
+        {
+            rank |= 2;
+        }
+
+        if (detail.startsWith(QLatin1String("SCAN")) && !detail.contains(QLatin1String("USING")))
+        {
+            rank |= 1;
+        }
+
+        if (detail.contains(QLatin1String("USING INDEX")))
+        {
+            rank |= 4;
+        }
+    }
+
+    return rank;
+}
+
+// Independently of any baseline, no query may scan the whole table or visit it at all. Neither may a query sort the matching rows
+// if the index of the sort order can seek all of its predicates or if no index can seek any of them.
+int expectedRankOf(const int predicateSet, const int sortColumn)
+{
+    for (int predicate = 0; predicate < predicateCount; ++predicate)
+    {
+        if ((predicateSet & (1 << predicate)) && predicates[predicate].sortColumn >= 0 && predicates[predicate].sortColumn != sortColumn)
+        {
+            return 2;
+        }
+    }
+
+    return 0;
+}
+
+// Captures plan and latency of every combination of predicates and sort order. Fails if a query exceeds the budget,
+// if its plan is worse than expected or if it is worse than the one recorded by the baseline, i.e. by the output of a previous run.
+bool runQueryShapes(Results& results, const Database& database, const QJsonObject& baseline, const double budget)
+{
+    auto ok = true;
+
+    QJsonObject shapes;
+
+    for (int predicateSet = 0; predicateSet < (1 << predicateCount); ++predicateSet)
+    {
+        Filter filter;
+        QStringList filterNames;
+
+        for (int predicate = 0; predicate < predicateCount; ++predicate)
+        {
+            if (predicateSet & (1 << predicate))
+            {
+                predicates[predicate].apply(filter);
+                filterNames.append(QString::fromLatin1(predicates[predicate].name));
+            }
+        }
+
+        for (int sortColumn = Database::SortChannel; sortColumn <= Database::SortDuration; ++sortColumn)
+        {
+            for (const auto sortOrder : { Qt::AscendingOrder, Qt::DescendingOrder })
+            {
+                const auto name = QStringLiteral("%1/%2/%3")
+                                  .arg(filterNames.isEmpty() ? QStringLiteral("none") : filterNames.join(QChar('+')),
+                                       sortColumnNames[sortColumn],
+                                       sortOrder == Qt::AscendingOrder ? QStringLiteral("ascending") : QStringLiteral("descending"));
+
+                const auto plan = database.explainQuery(filter, Database::SortColumn(sortColumn), sortOrder);
+
+                QElapsedTimer timer;
+                timer.start();
+
+                database.query(filter, Database::SortColumn(sortColumn), sortOrder);
+
+                const auto milliseconds = timer.nsecsElapsed() / 1000.0 / 1000.0;
+
+                if (milliseconds > budget)
+                {
+                    qWarning("Query %s took %.1f ms exceeding the budget of %.1f ms.", qPrintable(name), milliseconds, budget);
+
+                    ok = false;
+                }
+
+                if (rankOf(plan) > expectedRankOf(predicateSet, sortColumn))
+                {
+                    qWarning("Plan of query %s is worse than expected: '%s'.", qPrintable(name), qPrintable(plan.join(QStringLiteral("; "))));
+
+                    ok = false;
+                }
+
+                const auto baselinePlan = baseline.value(name).toObject().value(QStringLiteral("plan")).toVariant().toStringList();
+
+                if (!baselinePlan.isEmpty() && rankOf(plan) > rankOf(baselinePlan))
+                {
+                    qWarning("Plan of query %s regressed from '%s' to '%s'.", qPrintable(name),
+                             qPrintable(baselinePlan.join(QStringLiteral("; "))), qPrintable(plan.join(QStringLiteral("; "))));
+
+                    ok = false;
+                }
+
+                QJsonObject shape;
+
+                shape.insert(QStringLiteral("plan"), QJsonArray::fromStringList(plan));
+                shape.insert(QStringLiteral("milliseconds"), milliseconds);
+
+                shapes.insert(name, shape);
+            }
+        }
+    }
+
+    results.insert(QStringLiteral("queryShapes"), shapes);
+
+    return ok;
+}
+
+void runCompletion(Results& results, const Database& database, const int iterations)
+{
+    const auto topics = database.topics(QString());
+    const auto counts = database.topicCounts(QString());
+
+    std::unique_ptr< CompletionIndex > index;
+
+    results.run(QStringLiteral("completion/build"), 1, [&]()
+    {
+        index.reset(new CompletionIndex(topics, counts));
+    });
+
+    if (index->complete(QStringLiteral("nachr"), 1).empty())
+    {
+        qFatal("Failed to complete topics.");
+    }
+
+    for (const auto text : { "w", "nachr", "ichten", "spezial" })
+    {
+        results.run(QStringLiteral("completion/%1").arg(text), iterations, [&]()
+        {
+            index->complete(QString::fromLatin1(text), 64);
+        });
+    }
+}
+
+void runScrolling(Results& results, Database& database, const QString& engine)
+{
+    results.run(QStringLiteral("model/%1/scroll").arg(engine), 1, [&]()
+    {
+        Model model(database);
+        QAbstractItemModel& items = model;
+
+        const QModelIndex root;
+
+        for (int row = 0; row < scrolledRows; ++row)
+        {
+            while (row >= items.rowCount(root) && items.canFetchMore(root))
+            {
+                items.fetchMore(root);
+            }
+
+            if (row >= items.rowCount(root))
+            {
+                break;
+            }
+
+            for (int column = 0; column < items.columnCount(root); ++column)
+            {
+                items.data(items.index(row, column, root), Qt::DisplayRole);
+            }
+        }
+    });
+}
+
+// Compares the size of the database and the time to read every show or only its row using plain and compressed storage.
+void runStorage(Results& results, Settings& settings, Timings& timings, const QByteArray& data)
+{
+    settings.setInMemoryCatalogue(false);
+
+    QVector< quint64 > checksums;
+
+    for (const auto compressed : { false, true })
+    {
+        settings.setCompressedStorage(compressed);
+
+        const auto mode = compressed ? QStringLiteral("compressed") : QStringLiteral("plain");
+
+        Database database(settings, timings);
+        database.open();
+        database.waitForOpened();
+
+        results.run(QStringLiteral("storage/%1/fullUpdate").arg(mode), 1, [&]()
+        {
+            if (!runUpdate(database, &Database::fullUpdate, data))
+            {
+                qFatal("Failed to perform full update.");
+            }
+        });
+
+        results.insert(QStringLiteral("storage/%1/bytes").arg(mode), double(database.storageSize()));
+
+        const auto ids = database.query(Filter(), Database::SortDate, Qt::DescendingOrder);
+
+        // The checksum does not depend on the order of the shows as their identifiers change with each full update.
+        quint64 checksum = 0;
+
+        results.run(QStringLiteral("storage/%1/scan").arg(mode), 1, [&]()
+        {
+            for (const auto id : ids)
+            {
+                const auto show = database.show(id);
+
+                checksum += qHash(show->description) ^ qHash(show->website, 1) ^ qHash(show->url, 2);
+            }
+        });
+
+        checksums.append(checksum);
+
+        // Reading only the columns shown in the list skips descriptions and URLs entirely.
+        results.run(QStringLiteral("storage/%1/scanRows").arg(mode), 1, [&]()
+        {
+            for (const auto id : ids)
+            {
+                database.showRow(id);
+            }
+        });
+    }
+
+    if (checksums.first() != checksums.last())
+    {
+        qFatal("Compressed storage does not preserve descriptions and URLs.");
+    }
+
+    settings.setCompressedStorage(false);
+}
+
+void runStartup(Results& results, const QString& program, const int iterations)
+{
+    auto environment = QProcessEnvironment::systemEnvironment();
+
+    environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+    environment.insert(QStringLiteral("QMEDIATHEKVIEW_STARTUP"), QStringLiteral("1"));
+
+    // Makes the application use the settings and the database prepared by the benchmark.
+    environment.insert(QStringLiteral("XDG_DATA_HOME"), QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation));
+    environment.insert(QStringLiteral("XDG_CONFIG_HOME"), QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation));
+
+    QVector< double > firstFrame;
+    QVector< double > opened;
+
+    results.run(QStringLiteral("startup/process"), iterations, [&]()
+    {
+        QProcess process;
+        process.setProcessEnvironment(environment);
+        process.start(program, QStringList());
+
+        if (!process.waitForFinished(60 * 1000) || process.exitStatus() != QProcess::NormalExit)
+        {
+            qFatal("Failed to measure application startup.");
+        }
+
+        const auto report = QJsonDocument::fromJson(process.readAllStandardOutput()).object();
+
+        firstFrame.append(report.value(QStringLiteral("firstFrameMilliseconds")).toDouble());
+        opened.append(report.value(QStringLiteral("openedMilliseconds")).toDouble());
+    });
+
+    std::sort(firstFrame.begin(), firstFrame.end());
+    std::sort(opened.begin(), opened.end());
+
+    QJsonObject startup;
+
+    startup.insert(QStringLiteral("firstFrameMilliseconds"), firstFrame.at(firstFrame.size() / 2));
+    startup.insert(QStringLiteral("openedMilliseconds"), opened.at(opened.size() / 2));
+
+    results.insert(QStringLiteral("startup"), startup);
+}
+
+} // anonymous
+
+} // QMediathekView
+
+int main(int argc, char** argv)
+{
+    using namespace QMediathekView;
+
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setOrganizationName(QStringLiteral("QMediathekView"));
+    QCoreApplication::setApplicationName(QStringLiteral("QMediathekView"));
+
+    // Keeps the settings and the database of the benchmark separate from the user's data.
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::DataLocation)).removeRecursively();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Benchmarks QMediathekView using a synthetic show list."));
+    parser.addHelpOption();
+
+    const QCommandLineOption showsOption(QStringLiteral("shows"), QStringLiteral("Number of generated shows."), QStringLiteral("count"), QString::number(defaultShowCount));
+    const QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Number of iterations per benchmark."), QStringLiteral("count"), QString::number(defaultIterations));
+    const QCommandLineOption outputOption(QStringLiteral("output"), QStringLiteral("Write results to file instead of standard output."), QStringLiteral("file"));
+    const QCommandLineOption applicationOption(QStringLiteral("application"), QStringLiteral("Measure the startup of the given application binary."), QStringLiteral("binary"));
+    const QCommandLineOption shapesOption(QStringLiteral("shapes"), QStringLiteral("Check the plan and latency of every query shape."));
+    const QCommandLineOption baselineOption(QStringLiteral("baseline"), QStringLiteral("Fail if a query plan is worse than in the results of a previous run."), QStringLiteral("file"));
+    const QCommandLineOption budgetOption(QStringLiteral("budget"), QStringLiteral("Fail if a query shape takes longer."), QStringLiteral("milliseconds"), QString::number(defaultBudget));
+
+    parser.addOption(showsOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(outputOption);
+    parser.addOption(applicationOption);
+    parser.addOption(shapesOption);
+    parser.addOption(baselineOption);
+    parser.addOption(budgetOption);
+
+    parser.process(application);
+
+    const auto showCount = qMax(1, parser.value(showsOption).toInt());
+    const auto iterations = qMax(1, parser.value(iterationsOption).toInt());
+
+    Results results;
+
+    const auto data = generateFilmliste(showCount);
+    const auto partialData = generateFilmliste(qMax(1, showCount / 10));
+    const auto compressedData = compress(data);
+
+    results.insert(QStringLiteral("shows"), showCount);
+    results.insert(QStringLiteral("bytes"), double(data.size()));
+    results.insert(QStringLiteral("compressedBytes"), double(compressedData.size()));
+
+    results.run(QStringLiteral("decompress"), iterations, [&]()
+    {
+        Decompressor decompressor;
+        decompressor.appendData(compressedData);
+    });
+
+    results.run(QStringLiteral("parse"), iterations, [&]()
+    {
+        CountingProcessor processor;
+
+        if (!parse(data, processor) || processor.count != showCount)
+        {
+            qFatal("Failed to parse generated data.");
+        }
+    });
+
+    Settings settings;
+    Timings timings(settings);
+
+    settings.setInMemoryCatalogue(false);
+
+    // Repeated queries would otherwise only measure the query cache.
+    settings.setQueryCacheSize(0);
+
+    // The channels and topics maintained by the updates are checked against those loaded from the database.
+    QStringList channels;
+    QStringList topics;
+
+    QVector< QVector< quintptr > > matches;
+
+    auto ok = false;
+
+    {
+        Database database(settings, timings);
+        database.open();
+        database.waitForOpened();
+
+        timings.start();
+
+        results.run(QStringLiteral("fullUpdate"), 1, [&]()
+        {
+            if (!runUpdate(database, &Database::fullUpdate, data))
+            {
+                qFatal("Failed to perform full update.");
+            }
+        });
+
+        timings.finish(true);
+
+        results.insert(QStringLiteral("fullUpdateStages"), timings.toJson().value(QStringLiteral("stages")));
+
+        results.run(QStringLiteral("partialUpdate"), 1, [&]()
+        {
+            if (!runUpdate(database, &Database::partialUpdate, partialData))
+            {
+                qFatal("Failed to perform partial update.");
+            }
+        });
+
+        channels = database.channels();
+        topics = database.topics(QStringLiteral("ZDF"));
+
+        ok = checkQueryPlans(results, database);
+
+        if (parser.isSet(shapesOption))
+        {
+            QJsonObject baseline;
+
+            if (parser.isSet(baselineOption))
+            {
+                QFile file(parser.value(baselineOption));
+
+                if (!file.open(QIODevice::ReadOnly))
+                {
+                    qFatal("Failed to read baseline.");
+                }
+
+                baseline = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("queryShapes")).toObject();
+            }
+
+            ok &= runQueryShapes(results, database, baseline, parser.value(budgetOption).toDouble());
+        }
+
+        runQueries(results, database, QStringLiteral("sqlite"), iterations);
+        matches = matchQueries(database);
+
+        if (matches.last().isEmpty())
+        {
+            qFatal("Failed to match titles ignoring case and diacritics.");
+        }
+
+        runCompletion(results, database, iterations);
+        runScrolling(results, database, QStringLiteral("sqlite"));
+    }
+
+    settings.setInMemoryCatalogue(true);
+
+    {
+        std::unique_ptr< Database > database;
+
+        results.run(QStringLiteral("catalogue/build"), 1, [&]()
+        {
+            database.reset(new Database(settings, timings));
+            database->open();
+            database->waitForOpened();
+        });
+
+        if (database->channels() != channels || database->topics(QStringLiteral("ZDF")) != topics)
+        {
+            qFatal("Incrementally maintained channels and topics differ from the database.");
+        }
+
+        database.reset();
+
+        results.run(QStringLiteral("catalogue/open"), 1, [&]()
+        {
+            database.reset(new Database(settings, timings));
+            database->open();
+            database->waitForOpened();
+        });
+
+        // Opening a snapshot only verifies its header, so the first query and the first row also verify the sections they use.
+        results.run(QStringLiteral("catalogue/first-query"), 1, [&]()
+        {
+            const auto ids = database->query(Filter(), Database::SortDate, Qt::DescendingOrder);
+
+            if (!ids.isEmpty())
+            {
+                database->showRow(ids.first());
+            }
+        });
+
+        runQueries(results, *database, QStringLiteral("catalogue"), iterations);
+
+        if (matchQueries(*database) != matches)
+        {
+            qFatal("The catalogue and the database disagree on the results of a query.");
+        }
+        runScrolling(results, *database, QStringLiteral("catalogue"));
+    }
+
+    settings.setQueryCacheSize(16);
+
+    {
+        Database database(settings, timings);
+        database.open();
+        database.waitForOpened();
+
+        Filter filter;
+        filter.channel = QStringLiteral("ARD");
+        filter.title = QStringLiteral("Nachrichten");
+
+        const auto query = [&]()
+        {
+            return database.query(filter, Database::SortDate, Qt::DescendingOrder);
+        };
+
+        results.run(QStringLiteral("queryCache/miss"), 1, query);
+
+        if (query().isEmpty())
+        {
+            qFatal("Failed to query cached results.");
+        }
+
+        results.run(QStringLiteral("queryCache/hit"), iterations, query);
+    }
+
+    results.run(QStringLiteral("startup/firstRows"), iterations, [&]()
+    {
+        Database database(settings, timings);
+        database.open();
+        database.waitForOpened();
+
+        Model model(database);
+
+        if (model.rowCount(QModelIndex()) == 0)
+        {
+            qFatal("Failed to fetch first rows.");
+        }
+    });
+
+    if (parser.isSet(applicationOption))
+    {
+        runStartup(results, parser.value(applicationOption), iterations);
+    }
+
+    runStorage(results, settings, timings, data);
+
+#ifdef QMEDIATHEKVIEW_TRACING
+
+    if (qEnvironmentVariableIsSet("QMEDIATHEKVIEW_TRACE"))
+    {
+        Trace::dump(Trace::defaultFileName());
+    }
+
+#endif // QMEDIATHEKVIEW_TRACING
+
+    const auto json = results.toJson();
+
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+        {
+            qFatal("Failed to write results.");
+        }
+    }
+    else
+    {
+        QTextStream(stdout) << json;
+    }
+
+    return ok ? 0 : 1;
+}
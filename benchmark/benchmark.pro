@@ -0,0 +1,59 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+CONFIG(release, debug|release) {
+    QMAKE_CFLAGS += -flto
+    QMAKE_CXXFLAGS += -flto
+    QMAKE_LFLAGS += -flto
+}
+
+QT += core concurrent sql
+QT -= gui
+
+tracing {
+    DEFINES += QMEDIATHEKVIEW_TRACING
+}
+
+CONFIG += link_pkgconfig
+PKGCONFIG += liblzma zlib
+
+TARGET = benchmark
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../settings.cpp \
+    ../timings.cpp \
+    ../trace.cpp \
+    ../arena.cpp \
+    ../parser.cpp \
+    ../searchkey.cpp \
+    ../compression.cpp \
+    ../database.cpp \
+    ../catalogue.cpp \
+    ../channelindex.cpp \
+    ../completionindex.cpp \
+    ../completionmodel.cpp \
+    ../model.cpp \
+    ../decompressor.cpp \
+    generator.cpp \
+    benchmark.cpp
+
+HEADERS += \
+    ../settings.h \
+    ../timings.h \
+    ../trace.h \
+    ../schema.h \
+    ../arena.h \
+    ../parser.h \
+    ../searchkey.h \
+    ../compression.h \
+    ../database.h \
+    ../catalogue.h \
+    ../channelindex.h \
+    ../completionindex.h \
+    ../completionmodel.h \
+    ../model.h \
+    ../decompressor.h \
+    generator.h
@@ -0,0 +1,252 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "generator.h"
+
+#include <QDate>
+#include <QTime>
+
+#include <lzma.h>
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+const char* const channels[] =
+{
+    "3Sat", "ARD", "ARTE.DE", "ARTE.FR", "BR", "DW", "HR", "KiKA", "MDR", "NDR",
+    "ORF", "PHOENIX", "RBB", "SR", "SRF", "SRF.Podcast", "SWR", "WDR", "ZDF", "ZDF-tivi"
+};
+
+const char* const words[] =
+{
+    "Nachrichten", "Tagesschau", "Wetter", "Sport", "Kultur", "Politik", "Wirtschaft", "Wissen",
+    "Reportage", "Dokumentation", "Magazin", "Ärzte", "Überblick", "Grüße", "Straße", "Zürich",
+    "Köln", "München", "Düsseldorf", "Geschichte", "Natur", "Tiere", "Reise", "Küche",
+    "Gesundheit", "Familie", "Musik", "Konzert", "Krimi", "Serie", "Film", "Talk",
+    "Interview", "Gespräch", "Europa", "Deutschland", "Österreich", "Schweiz", "Welt", "Heimat"
+};
+
+constexpr auto channelCount = sizeof(channels) / sizeof(channels[0]);
+constexpr auto wordCount = sizeof(words) / sizeof(words[0]);
+
+constexpr auto showsPerTopic = 40;
+constexpr auto maximumDescriptionWords = 60;
+
+class Random
+{
+public:
+    explicit Random(const quint32 seed)
+        : m_state(seed)
+    {
+    }
+
+    quint32 next(const quint32 bound)
+    {
+        m_state = m_state * 1103515245u + 12345u;
+
+        return (m_state >> 8) % bound;
+    }
+
+    bool chance(const quint32 percent)
+    {
+        return next(100) < percent;
+    }
+
+private:
+    quint32 m_state;
+
+};
+
+void appendEscaped(QByteArray& data, const QByteArray& text)
+{
+    for (const auto character : text)
+    {
+        switch (character)
+        {
+        case '"':
+            data.append("\\\"");
+            break;
+        case '\\':
+            data.append("\\\\");
+            break;
+        case '\n':
+            data.append("\\n");
+            break;
+        case '\t':
+            data.append("\\t");
+            break;
+        default:
+            data.append(character);
+            break;
+        }
+    }
+}
+
+void appendItem(QByteArray& data, const QByteArray& text, const bool last = false)
+{
+    data.append('"');
+    appendEscaped(data, text);
+    data.append('"');
+
+    if (!last)
+    {
+        data.append(',');
+    }
+}
+
+QByteArray wordsOf(Random& random, const int count)
+{
+    QByteArray text;
+
+    for (int index = 0; index < count; ++index)
+    {
+        if (index != 0)
+        {
+            text.append(random.chance(5) ? '\n' : ' ');
+        }
+
+        text.append(words[random.next(wordCount)]);
+    }
+
+    return text;
+}
+
+QByteArray replacementOf(const QByteArray& url, const QByteArray& suffix)
+{
+    const auto offset = url.lastIndexOf('_') + 1;
+
+    return QByteArray::number(offset) + '|' + suffix;
+}
+
+} // anonymous
+
+QByteArray generateFilmliste(const int showCount, const quint32 seed)
+{
+    Random random(seed);
+
+    const QDate today(2016, 10, 16);
+    const auto topicsPerChannel = qMax(1, showCount / showsPerTopic / int(channelCount));
+
+    QByteArray data;
+    data.reserve(showCount * 640);
+
+    data.append("{\"Filmliste\":[\"16.10.2016, 09:00\",\"16.10.2016, 07:00\",\"3\",\"MSearch [Vers.: 2.0.0]\",\"0123456789abcdef\"],"
+                "\"Filmliste\":[\"Sender\",\"Thema\",\"Titel\",\"Datum\",\"Zeit\",\"Dauer\",\"Größe [MB]\",\"Beschreibung\",\"Url\",\"Website\","
+                "\"Untertitel\",\"UrlRTMP\",\"Url_Klein\",\"UrlRTMP_Klein\",\"Url_HD\",\"UrlRTMP_HD\",\"DatumL\",\"Url_History\",\"Geo\",\"neu\"]");
+
+    QByteArray previousChannel;
+    QByteArray previousTopic;
+
+    for (int show = 0; show < showCount;)
+    {
+        const QByteArray channel = channels[random.next(channelCount)];
+        const auto topicIndex = random.next(topicsPerChannel);
+
+        QByteArray topic = words[topicIndex % wordCount];
+
+        if (topicIndex >= wordCount)
+        {
+            topic += ' ' + QByteArray::number(topicIndex / wordCount);
+        }
+
+        if (random.chance(3))
+        {
+            topic += " \"Spezial\"";
+        }
+
+        for (auto episode = 1 + random.next(showsPerTopic); episode > 0 && show < showCount; --episode, ++show)
+        {
+            data.append(",\"X\":[");
+
+            // Channel and topic are left empty if they are the same as for the previous entry.
+            appendItem(data, channel != previousChannel ? channel : QByteArray());
+            appendItem(data, topic != previousTopic || channel != previousChannel ? topic : QByteArray());
+
+            previousChannel = channel;
+            previousTopic = topic;
+
+            appendItem(data, wordsOf(random, 1 + random.next(4)) + " (Folge " + QByteArray::number(episode) + ')');
+
+            const auto date = today.addDays(-qint64(random.next(30)));
+            const QTime time(random.next(24), random.next(60), 0);
+            const QTime duration(random.next(2), random.next(60), random.next(60));
+
+            appendItem(data, random.chance(95) ? date.toString(QStringLiteral("dd.MM.yyyy")).toUtf8() : QByteArray());
+            appendItem(data, random.chance(90) ? time.toString(QStringLiteral("hh:mm:ss")).toUtf8() : QByteArray());
+            appendItem(data, random.chance(95) ? duration.toString(QStringLiteral("hh:mm:ss")).toUtf8() : QByteArray());
+
+            appendItem(data, QByteArray::number(random.next(1000)));
+
+            appendItem(data, random.chance(90) ? wordsOf(random, random.next(maximumDescriptionWords)) : QByteArray());
+
+            const auto url = "http://cdn" + QByteArray::number(random.next(8)) + ".example.org/"
+                             + channel.toLower() + '/' + QByteArray::number(date.year()) + '/'
+                             + QByteArray::number(random.next(1000000)) + "_hd.mp4";
+
+            appendItem(data, url);
+            appendItem(data, "http://www.example.org/" + channel.toLower() + '/' + QByteArray::number(show));
+
+            appendItem(data, QByteArray());
+            appendItem(data, QByteArray());
+
+            appendItem(data, random.chance(85) ? replacementOf(url, "sd.mp4") : QByteArray());
+            appendItem(data, QByteArray());
+            appendItem(data, random.chance(70) ? replacementOf(url, "xl.mp4") : QByteArray());
+            appendItem(data, QByteArray());
+
+            appendItem(data, QByteArray::number(QDateTime(date, time).toTime_t()));
+            appendItem(data, QByteArray());
+            appendItem(data, random.chance(20) ? QByteArray("DE-AT-CH") : QByteArray());
+            appendItem(data, "false", true);
+
+            data.append(']');
+        }
+    }
+
+    data.append('}');
+
+    return data;
+}
+
+QByteArray compress(const QByteArray& data)
+{
+    QByteArray compressed(lzma_stream_buffer_bound(data.size()), '\0');
+    std::size_t size = 0;
+
+    const auto result = lzma_easy_buffer_encode(
+                            LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64, nullptr,
+                            reinterpret_cast< const std::uint8_t* >(data.constData()), data.size(),
+                            reinterpret_cast< std::uint8_t* >(compressed.data()), &size, compressed.size());
+
+    if (result != LZMA_OK)
+    {
+        return {};
+    }
+
+    compressed.resize(size);
+
+    return compressed;
+}
+
+} // QMediathekView
@@ -0,0 +1,1111 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "catalogue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QThread>
+
+#include <QtConcurrentMap>
+
+#include "searchkey.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr char magic[8] = { 'Q', 'M', 'V', 'C', 'A', 'T', 'L', '\0' };
+constexpr quint32 version = 3;
+
+constexpr quint64 alignment = 8;
+
+constexpr quint64 checksumBasis = 14695981039346656037ull;
+constexpr quint64 checksumPrime = 1099511628211ull;
+
+constexpr auto invalidDate = std::numeric_limits< qint32 >::min();
+
+constexpr auto chunksPerThread = 4;
+
+enum Section
+{
+    Ids,
+    Channels,
+    Topics,
+    Dates,
+    Times,
+    Durations,
+    UrlSmallOffsets,
+    UrlLargeOffsets,
+    TextOffsets,
+    TextArena,
+    SearchOffsets,
+    SearchArena,
+    ChannelOffsets,
+    ChannelArena,
+    ChannelRanks,
+    TopicOffsets,
+    TopicArena,
+    TopicRanks,
+    TitleRanks,
+    ChannelTopics,
+    ByChannel,
+    ByTopic,
+    ByTitle,
+    ByDate,
+    ByTime,
+    ByDuration,
+    SectionCount
+};
+
+enum TextField
+{
+    Title,
+    Description,
+    Website,
+    Url,
+    UrlSmallSuffix,
+    UrlLargeSuffix,
+    TextFieldCount
+};
+
+quint64 checksumOf(const char* data, const quint64 size, quint64 checksum)
+{
+    quint64 index = 0;
+
+    for (; index + sizeof(quint64) <= size; index += sizeof(quint64))
+    {
+        quint64 word;
+        std::memcpy(&word, data + index, sizeof(word));
+
+        checksum = (checksum ^ word) * checksumPrime;
+        checksum ^= checksum >> 32;
+    }
+
+    for (; index < size; ++index)
+    {
+        checksum = (checksum ^ quint8(data[index])) * checksumPrime;
+    }
+
+    return checksum;
+}
+
+const char* find(const char* begin, const char* end, const QByteArray& needle)
+{
+    const auto size = needle.size();
+    const auto first = needle.at(0);
+
+    for (const auto last = end - size + 1; begin < last; ++begin)
+    {
+        begin = static_cast< const char* >(std::memchr(begin, first, last - begin));
+
+        if (begin == nullptr)
+        {
+            break;
+        }
+
+        if (std::memcmp(begin + 1, needle.constData() + 1, size - 1) == 0)
+        {
+            return begin;
+        }
+    }
+
+    return nullptr;
+}
+
+void buildInterned(
+    const QHash< QString, quint32 >& ids,
+    std::vector< quint32 >& offsets, QByteArray& arena, std::vector< quint32 >& ranks)
+{
+    std::vector< QByteArray > texts(ids.size());
+
+    for (auto iterator = ids.begin(); iterator != ids.end(); ++iterator)
+    {
+        texts[iterator.value()] = iterator.key().toUtf8();
+    }
+
+    for (const auto& text : texts)
+    {
+        offsets.push_back(arena.size());
+        arena.append(text);
+    }
+
+    offsets.push_back(arena.size());
+
+    std::vector< quint32 > order(texts.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::sort(order.begin(), order.end(), [&texts](const quint32 lhs, const quint32 rhs)
+    {
+        return texts[lhs] < texts[rhs];
+    });
+
+    ranks.resize(texts.size());
+
+    for (quint32 rank = 0; rank < order.size(); ++rank)
+    {
+        ranks[order[rank]] = rank;
+    }
+}
+
+} // anonymous
+
+struct Catalogue::Header
+{
+    char magic[8];
+    quint32 version;
+
+    quint32 rowCount;
+    quint32 channelCount;
+    quint32 topicCount;
+    quint32 channelTopicCount;
+    quint32 reserved;
+
+    quint64 size;
+    quint64 checksum;
+
+    struct
+    {
+        quint64 offset;
+        quint64 size;
+        quint64 checksum;
+    } sections[SectionCount];
+
+};
+
+template< typename Type >
+struct Catalogue::Array
+{
+    const Type* data;
+    quint32 size;
+
+    const Type& operator[](const quint32 index) const
+    {
+        return data[index];
+    }
+
+    const Type* begin() const
+    {
+        return data;
+    }
+
+    const Type* end() const
+    {
+        return data + size;
+    }
+
+};
+
+namespace
+{
+
+void appendSection(QByteArray& data, Catalogue::Header& header, const int section, const char* values, const quint64 size)
+{
+    while (data.size() % alignment != 0)
+    {
+        data.append('\0');
+    }
+
+    header.sections[section].offset = data.size();
+    header.sections[section].size = size;
+    header.sections[section].checksum = checksumOf(values, size, checksumBasis);
+
+    data.append(values, size);
+}
+
+template< typename Type >
+void appendSection(QByteArray& data, Catalogue::Header& header, const int section, const std::vector< Type >& values)
+{
+    appendSection(data, header, section, reinterpret_cast< const char* >(values.data()), values.size() * sizeof(Type));
+}
+
+void appendSection(QByteArray& data, Catalogue::Header& header, const int section, const QByteArray& values)
+{
+    appendSection(data, header, section, values.constData(), values.size());
+}
+
+// Covers the section table including the checksums of the sections which are verified only once they are used.
+quint64 checksumOf(const Catalogue::Header& header)
+{
+    auto copy = header;
+    copy.checksum = 0;
+
+    return checksumOf(reinterpret_cast< const char* >(&copy), sizeof(copy), checksumBasis);
+}
+
+constexpr quint32 bitOf(const int section)
+{
+    return quint32(1) << section;
+}
+
+constexpr auto allSections = bitOf(SectionCount) - 1;
+
+quint32 sectionsOf(const Catalogue::Usage usage)
+{
+    constexpr auto channelTexts = bitOf(ChannelOffsets) | bitOf(ChannelArena);
+    constexpr auto topicTexts = bitOf(TopicOffsets) | bitOf(TopicArena);
+    constexpr auto showTexts = bitOf(TextOffsets) | bitOf(TextArena);
+
+    constexpr auto rows = bitOf(Ids) | bitOf(Channels) | bitOf(Topics) | bitOf(Dates) | bitOf(Times) | bitOf(Durations)
+                          | channelTexts | topicTexts | showTexts;
+    constexpr auto details = bitOf(Ids) | bitOf(UrlSmallOffsets) | bitOf(UrlLargeOffsets) | showTexts;
+
+    switch (usage)
+    {
+    default:
+    case Catalogue::Usage::Query:
+        return bitOf(Ids) | bitOf(Channels) | bitOf(Topics) | bitOf(Dates) | bitOf(Times) | bitOf(Durations)
+               | bitOf(SearchOffsets) | bitOf(SearchArena) | channelTexts | topicTexts
+               | bitOf(ChannelRanks) | bitOf(TopicRanks) | bitOf(TitleRanks)
+               | bitOf(ByChannel) | bitOf(ByTopic) | bitOf(ByTitle) | bitOf(ByDate) | bitOf(ByTime) | bitOf(ByDuration);
+    case Catalogue::Usage::Row:
+        return rows;
+    case Catalogue::Usage::Details:
+        return details;
+    case Catalogue::Usage::Show:
+        return rows | details;
+    case Catalogue::Usage::Channels:
+        return channelTexts | bitOf(ChannelRanks);
+    case Catalogue::Usage::Topics:
+        return channelTexts | topicTexts | bitOf(TopicRanks) | bitOf(ChannelTopics);
+    }
+}
+
+bool isValid(const char* data, const quint64 size)
+{
+    if (size < sizeof(Catalogue::Header))
+    {
+        return false;
+    }
+
+    const auto& header = *reinterpret_cast< const Catalogue::Header* >(data);
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.size != size)
+    {
+        return false;
+    }
+
+    for (const auto& section : header.sections)
+    {
+        if (section.offset % alignment != 0 || section.offset < sizeof(header) || section.offset > size || section.size > size - section.offset)
+        {
+            return false;
+        }
+    }
+
+    return checksumOf(header) == header.checksum;
+}
+
+} // anonymous
+
+Catalogue::Catalogue(const QByteArray& data)
+    : m_data(data)
+    , m_base(m_data.constData())
+    , m_header(reinterpret_cast< const Header* >(m_base))
+    , m_verifiedSections(allSections)
+    , m_corruptedSections(0)
+{
+}
+
+Catalogue::Catalogue(QFile* file, const char* data)
+    : m_file(file)
+    , m_base(data)
+    , m_header(reinterpret_cast< const Header* >(m_base))
+    , m_verifiedSections(0)
+    , m_corruptedSections(0)
+{
+}
+
+Catalogue::~Catalogue()
+{
+}
+
+std::shared_ptr< const Catalogue > Catalogue::open(const QString& filePath)
+{
+    std::unique_ptr< QFile > file(new QFile(filePath));
+
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    const auto size = file->size();
+    const auto data = reinterpret_cast< const char* >(file->map(0, size));
+
+    if (data == nullptr || !isValid(data, size))
+    {
+        return {};
+    }
+
+    return std::shared_ptr< const Catalogue >(new Catalogue(file.release(), data));
+}
+
+bool Catalogue::save(const QString& filePath) const
+{
+    QSaveFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    if (file.write(m_base, m_header->size) != qint64(m_header->size))
+    {
+        return false;
+    }
+
+    return file.commit();
+}
+
+int Catalogue::size() const
+{
+    return m_header->rowCount;
+}
+
+bool Catalogue::verify(const Usage usage) const
+{
+    const auto sections = sectionsOf(usage);
+
+    if ((m_verifiedSections.load(std::memory_order_acquire) & sections) == sections)
+    {
+        return true;
+    }
+
+    if ((m_corruptedSections.load(std::memory_order_relaxed) & sections) != 0)
+    {
+        return false;
+    }
+
+    // Concurrent callers might verify the same section twice which is harmless as the result does not change.
+    for (int section = 0; section < SectionCount; ++section)
+    {
+        const auto bit = bitOf(section);
+
+        if ((sections & bit) == 0 || (m_verifiedSections.load(std::memory_order_acquire) & bit) != 0)
+        {
+            continue;
+        }
+
+        const auto& location = m_header->sections[section];
+
+        if (checksumOf(m_base + location.offset, location.size, checksumBasis) != location.checksum)
+        {
+            qDebug() << "Section" << section << "of the catalogue snapshot is corrupted.";
+
+            m_corruptedSections.fetch_or(bit, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_verifiedSections.fetch_or(bit, std::memory_order_release);
+    }
+
+    return true;
+}
+
+quintptr Catalogue::generation() const
+{
+    const auto ids = array< qint64 >(Ids);
+
+    return ids.size != 0 ? ids[ids.size - 1] : 0;
+}
+
+QVector< quintptr > Catalogue::query(const Filter& filter, const Database::SortColumn sortColumn, const Qt::SortOrder sortOrder) const
+{
+    auto channelMask = matchInterned(ChannelOffsets, ChannelArena, filter.channel);
+    const auto topicMask = matchInterned(TopicOffsets, TopicArena, filter.topic);
+    const auto titleMask = matchTitles(filter.title);
+
+    const auto channelSetMask = matchChannels(filter.channels);
+
+    if (channelMask.empty())
+    {
+        channelMask = channelSetMask;
+    }
+    else if (!channelSetMask.empty())
+    {
+        for (std::size_t channel = 0; channel < channelMask.size(); ++channel)
+        {
+            channelMask[channel] &= channelSetMask[channel];
+        }
+    }
+
+    const auto ids = array< qint64 >(Ids);
+    const auto channels = array< quint32 >(Channels);
+    const auto topics = array< quint32 >(Topics);
+
+    const auto dates = array< qint32 >(Dates);
+    const auto times = array< qint32 >(Times);
+    const auto durations = array< qint32 >(Durations);
+
+    const auto hasDateRange = filter.fromDate.isValid() || filter.toDate.isValid();
+    const auto fromDate = filter.fromDate.isValid() ? qint32(filter.fromDate.toJulianDay()) : std::numeric_limits< qint32 >::min();
+    const auto toDate = filter.toDate.isValid() ? qint32(filter.toDate.toJulianDay()) : std::numeric_limits< qint32 >::max();
+
+    const auto fromTime = filter.fromTime.isValid() ? filter.fromTime.msecsSinceStartOfDay() : std::numeric_limits< qint32 >::min();
+    const auto toTime = filter.toTime.isValid() ? filter.toTime.msecsSinceStartOfDay() : std::numeric_limits< qint32 >::max();
+    const auto wrapsTime = filter.fromTime.isValid() && filter.toTime.isValid() && fromTime > toTime;
+
+    const auto minimumDuration = filter.minimumDuration.isValid() ? filter.minimumDuration.msecsSinceStartOfDay() : std::numeric_limits< qint32 >::min();
+    const auto maximumDuration = filter.maximumDuration.isValid() ? filter.maximumDuration.msecsSinceStartOfDay() : std::numeric_limits< qint32 >::max();
+
+    QVector< quintptr > id;
+
+    if (filter == Filter())
+    {
+        id.reserve(size());
+    }
+
+    // The packed columns are checked first as they are the cheapest to access.
+    visit(sortColumn, sortOrder, [&](const quint32 row)
+    {
+        const auto date = dates[row];
+
+        if (hasDateRange && (date == invalidDate || date < fromDate || date > toDate))
+        {
+            return;
+        }
+
+        const auto time = times[row];
+
+        if (wrapsTime ? (time < fromTime && time > toTime) : (time < fromTime || time > toTime))
+        {
+            return;
+        }
+
+        const auto duration = durations[row];
+
+        if (duration < minimumDuration || duration > maximumDuration)
+        {
+            return;
+        }
+
+        if (!channelMask.empty() && !channelMask[channels[row]])
+        {
+            return;
+        }
+
+        if (!topicMask.empty() && !topicMask[topics[row]])
+        {
+            return;
+        }
+
+        if (!titleMask.empty() && !titleMask[row])
+        {
+            return;
+        }
+
+        id.append(ids[row]);
+    });
+
+    return id;
+}
+
+std::unique_ptr< Show > Catalogue::show(const quintptr id) const
+{
+    std::unique_ptr< Show > show(new Show);
+
+    const auto row = rowOf(id);
+
+    if (row >= 0)
+    {
+        readRow(row, *show);
+        readDetails(row, *show);
+    }
+
+    return show;
+}
+
+std::unique_ptr< ShowRow > Catalogue::showRow(const quintptr id) const
+{
+    std::unique_ptr< ShowRow > show(new ShowRow);
+
+    const auto row = rowOf(id);
+
+    if (row >= 0)
+    {
+        readRow(row, *show);
+    }
+
+    return show;
+}
+
+std::unique_ptr< ShowDetails > Catalogue::showDetails(const quintptr id) const
+{
+    std::unique_ptr< ShowDetails > show(new ShowDetails);
+
+    const auto row = rowOf(id);
+
+    if (row >= 0)
+    {
+        readDetails(row, *show);
+    }
+
+    return show;
+}
+
+void Catalogue::readRow(const int row, ShowRow& show) const
+{
+    show.channel = text(ChannelOffsets, ChannelArena, array< quint32 >(Channels)[row]);
+    show.topic = text(TopicOffsets, TopicArena, array< quint32 >(Topics)[row]);
+    show.title = text(TextOffsets, TextArena, row * TextFieldCount + Title);
+
+    const auto date = array< qint32 >(Dates)[row];
+    show.date = date != invalidDate ? QDate::fromJulianDay(date) : QDate();
+    show.time = QTime::fromMSecsSinceStartOfDay(array< qint32 >(Times)[row]);
+
+    show.duration = QTime::fromMSecsSinceStartOfDay(array< qint32 >(Durations)[row]);
+}
+
+void Catalogue::readDetails(const int row, ShowDetails& show) const
+{
+    const auto textOf = [this, row](const TextField field)
+    {
+        return text(TextOffsets, TextArena, row * TextFieldCount + field);
+    };
+
+    show.description = textOf(Description);
+    show.website = textOf(Website);
+
+    show.url = textOf(Url);
+
+    show.urlSmallOffset = array< quint16 >(UrlSmallOffsets)[row];
+    show.urlSmallSuffix = textOf(UrlSmallSuffix);
+
+    show.urlLargeOffset = array< quint16 >(UrlLargeOffsets)[row];
+    show.urlLargeSuffix = textOf(UrlLargeSuffix);
+}
+
+QStringList Catalogue::channels() const
+{
+    const auto ranks = array< quint32 >(ChannelRanks);
+
+    QVector< QString > channels(ranks.size);
+
+    for (quint32 channel = 0; channel < ranks.size; ++channel)
+    {
+        channels[ranks[channel]] = text(ChannelOffsets, ChannelArena, channel);
+    }
+
+    return channels.toList();
+}
+
+QStringList Catalogue::topics(const QString& channel) const
+{
+    const auto channelMask = matchInterned(ChannelOffsets, ChannelArena, channel);
+
+    const auto ranks = array< quint32 >(TopicRanks);
+    const auto channelTopics = array< quint64 >(ChannelTopics);
+
+    std::vector< char > included(ranks.size, 0);
+
+    for (const auto channelTopic : channelTopics)
+    {
+        if (channelMask.empty() || channelMask[channelTopic >> 32])
+        {
+            included[channelTopic & 0xFFFFFFFF] = 1;
+        }
+    }
+
+    std::vector< quint32 > byRank(ranks.size);
+
+    for (quint32 topic = 0; topic < ranks.size; ++topic)
+    {
+        byRank[ranks[topic]] = topic;
+    }
+
+    QStringList topics;
+
+    for (const auto topic : byRank)
+    {
+        if (included[topic])
+        {
+            topics.append(text(TopicOffsets, TopicArena, topic));
+        }
+    }
+
+    return topics;
+}
+
+template< typename Type >
+Catalogue::Array< Type > Catalogue::array(const int section) const
+{
+    const auto& location = m_header->sections[section];
+
+    return { reinterpret_cast< const Type* >(m_base + location.offset), quint32(location.size / sizeof(Type)) };
+}
+
+QString Catalogue::text(const int offsetsSection, const int arenaSection, const quint32 index) const
+{
+    const auto offsets = array< quint32 >(offsetsSection);
+    const auto arena = array< char >(arenaSection);
+
+    const auto begin = offsets[index];
+    const auto end = offsets[index + 1];
+
+    return QString::fromUtf8(arena.data + begin, end - begin);
+}
+
+int Catalogue::rowOf(const quintptr id) const
+{
+    const auto ids = array< qint64 >(Ids);
+
+    const auto position = std::lower_bound(ids.begin(), ids.end(), qint64(id));
+
+    if (position == ids.end() || *position != qint64(id))
+    {
+        return -1;
+    }
+
+    return position - ids.begin();
+}
+
+std::vector< char > Catalogue::matchInterned(const int offsetsSection, const int arenaSection, const QString& filter) const
+{
+    std::vector< char > mask;
+
+    if (filter.isEmpty())
+    {
+        return mask;
+    }
+
+    const auto needle = searchKeyOf(filter).toUtf8();
+
+    if (needle.isEmpty())
+    {
+        return mask;
+    }
+
+    const auto offsets = array< quint32 >(offsetsSection);
+
+    mask.resize(offsets.size - 1, 0);
+
+    for (quint32 index = 0; index < mask.size(); ++index)
+    {
+        const auto haystack = searchKeyOf(text(offsetsSection, arenaSection, index)).toUtf8();
+
+        mask[index] = find(haystack.constData(), haystack.constData() + haystack.size(), needle) != nullptr;
+    }
+
+    return mask;
+}
+
+std::vector< char > Catalogue::matchChannels(const QStringList& channels) const
+{
+    std::vector< char > mask;
+
+    if (channels.isEmpty())
+    {
+        return mask;
+    }
+
+    const auto offsets = array< quint32 >(ChannelOffsets);
+
+    mask.resize(offsets.size - 1, 0);
+
+    for (quint32 channel = 0; channel < mask.size(); ++channel)
+    {
+        mask[channel] = channels.contains(text(ChannelOffsets, ChannelArena, channel));
+    }
+
+    return mask;
+}
+
+std::vector< char > Catalogue::matchTitles(const QString& filter) const
+{
+    std::vector< char > mask;
+
+    if (filter.isEmpty())
+    {
+        return mask;
+    }
+
+    const auto needle = searchKeyOf(filter).toUtf8();
+
+    if (needle.isEmpty())
+    {
+        return mask;
+    }
+
+    const auto offsets = array< quint32 >(SearchOffsets);
+    const auto arena = array< char >(SearchArena);
+
+    const quint32 rowCount = size();
+    mask.resize(rowCount, 0);
+
+    struct Chunk
+    {
+        quint32 begin;
+        quint32 end;
+    };
+
+    QVector< Chunk > chunks;
+
+    const quint32 chunkCount = qMax(1, QThread::idealThreadCount() * chunksPerThread);
+    const quint32 chunkSize = qMax(quint32(1), (rowCount + chunkCount - 1) / chunkCount);
+
+    for (quint32 begin = 0; begin < rowCount; begin += chunkSize)
+    {
+        chunks.append({ begin, qMin(begin + chunkSize, rowCount) });
+    }
+
+    // The folded titles are separated by null characters, so that a match can never span two rows
+    // and a whole chunk can be scanned using a single search instead of one search per row.
+    QtConcurrent::blockingMap(chunks, [&](Chunk& chunk)
+    {
+        const auto first = offsets.begin() + chunk.begin;
+        const auto last = offsets.begin() + chunk.end;
+
+        const auto end = arena.data + *last;
+
+        for (auto position = arena.data + *first; (position = find(position, end, needle)) != nullptr;)
+        {
+            const auto offset = quint32(position - arena.data);
+            const auto next = std::upper_bound(first, last, offset);
+            const auto row = quint32(next - offsets.begin()) - 1;
+
+            mask[row] = 1;
+
+            position = arena.data + *next;
+        }
+    });
+
+    return mask;
+}
+
+template< typename Visitor >
+void Catalogue::visit(const Database::SortColumn sortColumn, const Qt::SortOrder sortOrder, Visitor visitor) const
+{
+    int section;
+
+    const quint32* rowKeys = nullptr;
+    const quint32* ranks = nullptr;
+
+    switch (sortColumn)
+    {
+    default:
+    case Database::SortChannel:
+        section = ByChannel;
+        rowKeys = array< quint32 >(Channels).data;
+        ranks = array< quint32 >(ChannelRanks).data;
+        break;
+    case Database::SortTopic:
+        section = ByTopic;
+        rowKeys = array< quint32 >(Topics).data;
+        ranks = array< quint32 >(TopicRanks).data;
+        break;
+    case Database::SortTitle:
+        section = ByTitle;
+        ranks = array< quint32 >(TitleRanks).data;
+        break;
+    case Database::SortDate:
+        section = ByDate;
+        break;
+    case Database::SortTime:
+        section = ByTime;
+        break;
+    case Database::SortDuration:
+        section = ByDuration;
+        break;
+    }
+
+    const auto permutation = array< quint32 >(section);
+
+    if (sortOrder != Qt::DescendingOrder)
+    {
+        for (const auto row : permutation)
+        {
+            visitor(row);
+        }
+
+        return;
+    }
+
+    if (ranks == nullptr)
+    {
+        for (auto index = permutation.size; index-- > 0;)
+        {
+            visitor(permutation[index]);
+        }
+
+        return;
+    }
+
+    // Textual columns are tie-broken by date and time in descending order irrespective of the sort order,
+    // hence the groups of equal rank are visited in reverse but the rows within each group are not.
+    const auto rankOf = [rowKeys, ranks](const quint32 row)
+    {
+        return rowKeys != nullptr ? ranks[rowKeys[row]] : ranks[row];
+    };
+
+    for (auto end = permutation.size; end > 0;)
+    {
+        auto begin = end - 1;
+        const auto rank = rankOf(permutation[begin]);
+
+        while (begin > 0 && rankOf(permutation[begin - 1]) == rank)
+        {
+            --begin;
+        }
+
+        for (auto index = begin; index < end; ++index)
+        {
+            visitor(permutation[index]);
+        }
+
+        end = begin;
+    }
+}
+
+Catalogue::Builder::Builder()
+{
+}
+
+Catalogue::Builder::~Builder()
+{
+}
+
+void Catalogue::Builder::append(const quintptr id, const Show& show)
+{
+    m_ids.push_back(id);
+
+    m_channels.push_back(intern(m_channelIds, show.channel));
+    m_topics.push_back(intern(m_topicIds, show.topic));
+
+    m_dates.push_back(show.date.isValid() ? qint32(show.date.toJulianDay()) : invalidDate);
+    m_times.push_back(show.time.msecsSinceStartOfDay());
+
+    m_durations.push_back(show.duration.msecsSinceStartOfDay());
+
+    m_urlSmallOffsets.push_back(show.urlSmallOffset);
+    m_urlLargeOffsets.push_back(show.urlLargeOffset);
+
+    const QString* const texts[TextFieldCount] =
+    {
+        &show.title,
+        &show.description,
+        &show.website,
+        &show.url,
+        &show.urlSmallSuffix,
+        &show.urlLargeSuffix
+    };
+
+    for (const auto text : texts)
+    {
+        m_textOffsets.push_back(m_textArena.size());
+        m_textArena.append(text->toUtf8());
+    }
+
+    m_searchOffsets.push_back(m_searchArena.size());
+    m_searchArena.append(searchKeyOf(show.title).toUtf8());
+    m_searchArena.append('\0');
+}
+
+std::shared_ptr< const Catalogue > Catalogue::Builder::build()
+{
+    const quint32 rowCount = m_ids.size();
+
+    m_textOffsets.push_back(m_textArena.size());
+    m_searchOffsets.push_back(m_searchArena.size());
+
+    std::vector< quint32 > channelOffsets;
+    QByteArray channelArena;
+    std::vector< quint32 > channelRanks;
+
+    buildInterned(m_channelIds, channelOffsets, channelArena, channelRanks);
+
+    std::vector< quint32 > topicOffsets;
+    QByteArray topicArena;
+    std::vector< quint32 > topicRanks;
+
+    buildInterned(m_topicIds, topicOffsets, topicArena, topicRanks);
+
+    std::vector< quint32 > rows(rowCount);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    const auto titleOf = [this](const quint32 row)
+    {
+        const auto begin = m_textOffsets[row * TextFieldCount + Title];
+        const auto end = m_textOffsets[row * TextFieldCount + Title + 1];
+
+        return QByteArray::fromRawData(m_textArena.constData() + begin, end - begin);
+    };
+
+    std::vector< quint32 > titleRanks(rowCount);
+
+    {
+        auto byTitle = rows;
+
+        std::sort(byTitle.begin(), byTitle.end(), [&titleOf](const quint32 lhs, const quint32 rhs)
+        {
+            return titleOf(lhs) < titleOf(rhs);
+        });
+
+        quint32 rank = 0;
+
+        for (quint32 index = 0; index < rowCount; ++index)
+        {
+            if (index > 0 && titleOf(byTitle[index - 1]) != titleOf(byTitle[index]))
+            {
+                ++rank;
+            }
+
+            titleRanks[byTitle[index]] = rank;
+        }
+    }
+
+    const auto sortByRank = [this, &rows](const std::function< quint32(quint32) >& rankOf)
+    {
+        auto permutation = rows;
+
+        std::sort(permutation.begin(), permutation.end(), [this, &rankOf](const quint32 lhs, const quint32 rhs)
+        {
+            const auto lhsRank = rankOf(lhs);
+            const auto rhsRank = rankOf(rhs);
+
+            if (lhsRank != rhsRank)
+            {
+                return lhsRank < rhsRank;
+            }
+
+            if (m_dates[lhs] != m_dates[rhs])
+            {
+                return m_dates[lhs] > m_dates[rhs];
+            }
+
+            return m_times[lhs] > m_times[rhs];
+        });
+
+        return permutation;
+    };
+
+    const auto sortByValue = [&rows](const std::vector< qint32 >& values)
+    {
+        auto permutation = rows;
+
+        std::stable_sort(permutation.begin(), permutation.end(), [&values](const quint32 lhs, const quint32 rhs)
+        {
+            return values[lhs] < values[rhs];
+        });
+
+        return permutation;
+    };
+
+    const auto byChannel = sortByRank([this, &channelRanks](const quint32 row)
+    {
+        return channelRanks[m_channels[row]];
+    });
+
+    const auto byTopic = sortByRank([this, &topicRanks](const quint32 row)
+    {
+        return topicRanks[m_topics[row]];
+    });
+
+    const auto byTitle = sortByRank([&titleRanks](const quint32 row)
+    {
+        return titleRanks[row];
+    });
+
+    const auto byDate = sortByValue(m_dates);
+    const auto byTime = sortByValue(m_times);
+    const auto byDuration = sortByValue(m_durations);
+
+    std::vector< quint64 > channelTopics;
+    channelTopics.reserve(rowCount);
+
+    for (quint32 row = 0; row < rowCount; ++row)
+    {
+        channelTopics.push_back(quint64(m_channels[row]) << 32 | m_topics[row]);
+    }
+
+    std::sort(channelTopics.begin(), channelTopics.end());
+    channelTopics.erase(std::unique(channelTopics.begin(), channelTopics.end()), channelTopics.end());
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+
+    header.rowCount = rowCount;
+    header.channelCount = channelRanks.size();
+    header.topicCount = topicRanks.size();
+    header.channelTopicCount = channelTopics.size();
+
+    QByteArray data(sizeof(Header), '\0');
+    data.reserve(sizeof(Header) + m_textArena.size() + m_searchArena.size() + rowCount * 128);
+
+    appendSection(data, header, Ids, m_ids);
+    appendSection(data, header, Channels, m_channels);
+    appendSection(data, header, Topics, m_topics);
+    appendSection(data, header, Dates, m_dates);
+    appendSection(data, header, Times, m_times);
+    appendSection(data, header, Durations, m_durations);
+    appendSection(data, header, UrlSmallOffsets, m_urlSmallOffsets);
+    appendSection(data, header, UrlLargeOffsets, m_urlLargeOffsets);
+    appendSection(data, header, TextOffsets, m_textOffsets);
+    appendSection(data, header, TextArena, m_textArena);
+    appendSection(data, header, SearchOffsets, m_searchOffsets);
+    appendSection(data, header, SearchArena, m_searchArena);
+    appendSection(data, header, ChannelOffsets, channelOffsets);
+    appendSection(data, header, ChannelArena, channelArena);
+    appendSection(data, header, ChannelRanks, channelRanks);
+    appendSection(data, header, TopicOffsets, topicOffsets);
+    appendSection(data, header, TopicArena, topicArena);
+    appendSection(data, header, TopicRanks, topicRanks);
+    appendSection(data, header, TitleRanks, titleRanks);
+    appendSection(data, header, ChannelTopics, channelTopics);
+    appendSection(data, header, ByChannel, byChannel);
+    appendSection(data, header, ByTopic, byTopic);
+    appendSection(data, header, ByTitle, byTitle);
+    appendSection(data, header, ByDate, byDate);
+    appendSection(data, header, ByTime, byTime);
+    appendSection(data, header, ByDuration, byDuration);
+
+    header.size = data.size();
+    header.checksum = checksumOf(header);
+
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    return std::shared_ptr< const Catalogue >(new Catalogue(data));
+}
+
+quint32 Catalogue::Builder::intern(QHash< QString, quint32 >& ids, const QString& text)
+{
+    auto id = ids.constFind(text);
+
+    if (id == ids.constEnd())
+    {
+        id = ids.insert(text, ids.size());
+    }
+
+    return id.value();
+}
+
+} // QMediathekView
@@ -0,0 +1,171 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CATALOGUE_H
+#define CATALOGUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+#include "database.h"
+
+class QFile;
+
+namespace QMediathekView
+{
+
+/*
+
+An immutable, column-oriented image of the shows table.
+
+All columns are stored as flat arrays inside a single buffer: channels and topics
+are interned and referenced by index, dates, times and durations are packed integers
+and all text is kept as UTF-8 in one contiguous arena. Each sort order is precomputed
+as a permutation of the rows, so that a query only needs to filter and not to sort.
+
+Since the buffer contains no pointers, it can be saved as a snapshot and later be
+memory-mapped and queried directly without parsing or copying. Opening a snapshot
+only verifies the checksum of its header and section table, while each section is
+verified by its own checksum the first time it is needed.
+
+*/
+class Catalogue
+{
+public:
+    class Builder;
+
+    ~Catalogue();
+
+    static std::shared_ptr< const Catalogue > open(const QString& filePath);
+    bool save(const QString& filePath) const;
+
+    enum class Usage
+    {
+        Query,
+        Row,
+        Details,
+        Show,
+        Channels,
+        Topics
+
+    };
+
+    // Verifies the sections needed for the given usage unless this was already done.
+    // The catalogue must not be used in this way if they are corrupted.
+    bool verify(const Usage usage) const;
+
+    int size() const;
+    quintptr generation() const;
+
+    QVector< quintptr > query(const Filter& filter, const Database::SortColumn sortColumn, const Qt::SortOrder sortOrder) const;
+
+    std::unique_ptr< Show > show(const quintptr id) const;
+    std::unique_ptr< ShowRow > showRow(const quintptr id) const;
+    std::unique_ptr< ShowDetails > showDetails(const quintptr id) const;
+
+    QStringList channels() const;
+    QStringList topics(const QString& channel) const;
+
+public:
+    struct Header;
+
+private:
+    explicit Catalogue(const QByteArray& data);
+    Catalogue(QFile* file, const char* data);
+
+    QByteArray m_data;
+    std::unique_ptr< QFile > m_file;
+
+    const char* m_base;
+    const Header* m_header;
+
+    mutable std::atomic< quint32 > m_verifiedSections;
+    mutable std::atomic< quint32 > m_corruptedSections;
+
+    template< typename Type >
+    struct Array;
+
+    template< typename Type >
+    Array< Type > array(const int section) const;
+
+    QString text(const int offsetsSection, const int arenaSection, const quint32 index) const;
+
+    int rowOf(const quintptr id) const;
+
+    void readRow(const int row, ShowRow& show) const;
+    void readDetails(const int row, ShowDetails& show) const;
+
+    std::vector< char > matchInterned(const int offsetsSection, const int arenaSection, const QString& filter) const;
+    std::vector< char > matchChannels(const QStringList& channels) const;
+    std::vector< char > matchTitles(const QString& filter) const;
+
+    template< typename Visitor >
+    void visit(const Database::SortColumn sortColumn, const Qt::SortOrder sortOrder, Visitor visitor) const;
+
+};
+
+class Catalogue::Builder
+{
+public:
+    Builder();
+    ~Builder();
+
+    void append(const quintptr id, const Show& show);
+
+    std::shared_ptr< const Catalogue > build();
+
+private:
+    Q_DISABLE_COPY(Builder)
+
+    std::vector< qint64 > m_ids;
+
+    std::vector< quint32 > m_channels;
+    std::vector< quint32 > m_topics;
+
+    std::vector< qint32 > m_dates;
+    std::vector< qint32 > m_times;
+    std::vector< qint32 > m_durations;
+
+    std::vector< quint16 > m_urlSmallOffsets;
+    std::vector< quint16 > m_urlLargeOffsets;
+
+    std::vector< quint32 > m_textOffsets;
+    QByteArray m_textArena;
+
+    std::vector< quint32 > m_searchOffsets;
+    QByteArray m_searchArena;
+
+    QHash< QString, quint32 > m_channelIds;
+    QHash< QString, quint32 > m_topicIds;
+
+    quint32 intern(QHash< QString, quint32 >& ids, const QString& text);
+
+};
+
+} // QMediathekView
+
+#endif // CATALOGUE_H
@@ -0,0 +1,146 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "channelindex.h"
+
+#include "searchkey.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+template< typename Map >
+void decrement(Map& map, const typename Map::key_type& key)
+{
+    const auto iterator = map.find(key);
+
+    if (iterator != map.end() && --iterator.value() <= 0)
+    {
+        map.erase(iterator);
+    }
+}
+
+} // anonymous
+
+void ChannelIndex::insert(const QString& channel, const QString& topic, const int count)
+{
+    m_channels[channel][topic] += count;
+    m_topics[topic] += count;
+}
+
+void ChannelIndex::remove(const QString& channel, const QString& topic)
+{
+    const auto iterator = m_channels.find(channel);
+
+    if (iterator == m_channels.end() || !iterator.value().contains(topic))
+    {
+        return;
+    }
+
+    decrement(iterator.value(), topic);
+    decrement(m_topics, topic);
+
+    if (iterator.value().isEmpty())
+    {
+        m_channels.erase(iterator);
+    }
+}
+
+int ChannelIndex::count(const QString& channel, const QString& topic) const
+{
+    return m_channels.value(channel).value(topic);
+}
+
+QStringList ChannelIndex::channels() const
+{
+    return m_channels.keys();
+}
+
+QStringList ChannelIndex::topics(const QString& channel) const
+{
+    return topicCounts(channel).keys();
+}
+
+ChannelIndex::Counts ChannelIndex::channelCounts() const
+{
+    Counts counts;
+
+    for (auto iterator = m_channels.begin(); iterator != m_channels.end(); ++iterator)
+    {
+        auto& count = counts[iterator.key()];
+
+        for (const auto topicCount : iterator.value())
+        {
+            count += topicCount;
+        }
+    }
+
+    return counts;
+}
+
+ChannelIndex::Counts ChannelIndex::topicCounts(const QString& channel) const
+{
+    if (channel.isEmpty())
+    {
+        return m_topics;
+    }
+
+    const auto needle = searchKeyOf(channel);
+
+    const Counts* matched = nullptr;
+    Counts merged;
+
+    for (auto iterator = m_channels.begin(); iterator != m_channels.end(); ++iterator)
+    {
+        if (!searchKeyOf(iterator.key()).contains(needle))
+        {
+            continue;
+        }
+
+        if (matched == nullptr)
+        {
+            matched = &iterator.value();
+            continue;
+        }
+
+        if (merged.isEmpty())
+        {
+            merged = *matched;
+        }
+
+        for (auto topic = iterator.value().begin(); topic != iterator.value().end(); ++topic)
+        {
+            merged[topic.key()] += topic.value();
+        }
+    }
+
+    if (!merged.isEmpty())
+    {
+        return merged;
+    }
+
+    return matched != nullptr ? *matched : Counts();
+}
+
+} // QMediathekView
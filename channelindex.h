@@ -0,0 +1,60 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef CHANNELINDEX_H
+#define CHANNELINDEX_H
+
+#include <QMap>
+#include <QStringList>
+
+namespace QMediathekView
+{
+
+// Counts the shows of each topic per channel, so that the channel and topic lists
+// can be served from memory and updated show by show instead of being queried again.
+class ChannelIndex
+{
+public:
+    typedef QMap< QString, int > Counts;
+
+    void insert(const QString& channel, const QString& topic, const int count = 1);
+    void remove(const QString& channel, const QString& topic);
+
+    int count(const QString& channel, const QString& topic) const;
+
+    QStringList channels() const;
+
+    // Yields the topics of all channels containing the given filter, matching like the database does.
+    QStringList topics(const QString& channel) const;
+
+    Counts channelCounts() const;
+    Counts topicCounts(const QString& channel) const;
+
+private:
+    QMap< QString, Counts > m_channels;
+    Counts m_topics;
+
+};
+
+} // QMediathekView
+
+#endif // CHANNELINDEX_H
@@ -0,0 +1,396 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "commandline.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include "settings.h"
+#include "timings.h"
+#include "database.h"
+#include "server.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+const char* const commands[] =
+{
+    "--update", "--search", "--serve"
+};
+
+const char* const sortColumnNames[] =
+{
+    "channel", "topic", "title", "date", "time", "duration"
+};
+
+namespace Keys
+{
+
+const auto channel = QStringLiteral("channel");
+const auto topic = QStringLiteral("topic");
+const auto title = QStringLiteral("title");
+const auto date = QStringLiteral("date");
+const auto time = QStringLiteral("time");
+const auto duration = QStringLiteral("duration");
+const auto url = QStringLiteral("url");
+const auto urlSmall = QStringLiteral("urlSmall");
+const auto urlLarge = QStringLiteral("urlLarge");
+const auto website = QStringLiteral("website");
+const auto description = QStringLiteral("description");
+
+} // Keys
+
+void appendField(QByteArray& line, const QString& field)
+{
+    if (!line.isEmpty())
+    {
+        line.append('\t');
+    }
+
+    // Tabs and line breaks are escaped so that every show stays on a single line.
+    for (const auto character : field.toUtf8())
+    {
+        switch (character)
+        {
+        case '\\':
+            line.append("\\\\");
+            break;
+        case '\t':
+            line.append("\\t");
+            break;
+        case '\n':
+            line.append("\\n");
+            break;
+        case '\r':
+            line.append("\\r");
+            break;
+        default:
+            line.append(character);
+            break;
+        }
+    }
+}
+
+QByteArray toTsv(const Show& show)
+{
+    QByteArray line;
+
+    appendField(line, show.channel);
+    appendField(line, show.topic);
+    appendField(line, show.title);
+    appendField(line, show.date.toString(Qt::ISODate));
+    appendField(line, show.time.toString(Qt::ISODate));
+    appendField(line, show.duration.toString(Qt::ISODate));
+    appendField(line, show.url);
+    appendField(line, show.urlSmall());
+    appendField(line, show.urlLarge());
+    appendField(line, show.website);
+    appendField(line, show.description);
+
+    line.append('\n');
+
+    return line;
+}
+
+QByteArray toJsonLine(const Show& show)
+{
+    QJsonObject object;
+
+    object.insert(Keys::channel, show.channel);
+    object.insert(Keys::topic, show.topic);
+    object.insert(Keys::title, show.title);
+    object.insert(Keys::date, show.date.toString(Qt::ISODate));
+    object.insert(Keys::time, show.time.toString(Qt::ISODate));
+    object.insert(Keys::duration, show.duration.toString(Qt::ISODate));
+    object.insert(Keys::url, show.url);
+    object.insert(Keys::urlSmall, show.urlSmall());
+    object.insert(Keys::urlLarge, show.urlLarge());
+    object.insert(Keys::website, show.website);
+    object.insert(Keys::description, show.description);
+
+    return QJsonDocument(object).toJson(QJsonDocument::Compact).append('\n');
+}
+
+} // anonymous
+
+CommandLine::CommandLine(int& argc, char** argv)
+    : QCoreApplication(argc, argv)
+    , m_settings(new Settings(this))
+    , m_timings(new Timings(*m_settings, this))
+    , m_database(new Database(*m_settings, *m_timings, this))
+    , m_updater(new Updater(*m_settings, *m_timings, *m_database, this))
+{
+}
+
+CommandLine::~CommandLine()
+{
+}
+
+bool CommandLine::isRequested(int argc, char** argv)
+{
+    for (int index = 1; index < argc; ++index)
+    {
+        const QByteArray argument(argv[index]);
+
+        for (const auto command : commands)
+        {
+            if (argument == command || argument.startsWith(QByteArray(command) + '='))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int CommandLine::exec()
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(tr("Updates and searches the list of shows without a display."));
+    parser.addHelpOption();
+
+    const QCommandLineOption updateOption(QStringLiteral("update"), tr("Update the database, either 'full', 'partial' or 'automatic'."), QStringLiteral("kind"));
+    const QCommandLineOption timingsOption(QStringLiteral("timings"), tr("Print the timings of the update to standard error."));
+    const QCommandLineOption searchOption(QStringLiteral("search"), tr("Print the shows matching the filters to standard output."));
+    const QCommandLineOption channelOption(QStringLiteral("channel"), tr("Only shows of the given channel."), QStringLiteral("channel"));
+    const QCommandLineOption topicOption(QStringLiteral("topic"), tr("Only shows of the given topic."), QStringLiteral("topic"));
+    const QCommandLineOption titleOption(QStringLiteral("title"), tr("Only shows whose title contains the given text."), QStringLiteral("title"));
+    const QCommandLineOption channelsOption(QStringLiteral("channels"), tr("Only shows of exactly these comma-separated channels."), QStringLiteral("channels"));
+    const QCommandLineOption fromDateOption(QStringLiteral("from-date"), tr("Only shows broadcast on or after the given date."), QStringLiteral("yyyy-mm-dd"));
+    const QCommandLineOption toDateOption(QStringLiteral("to-date"), tr("Only shows broadcast on or before the given date."), QStringLiteral("yyyy-mm-dd"));
+    const QCommandLineOption fromTimeOption(QStringLiteral("from-time"), tr("Only shows broadcast at or after the given time of day."), QStringLiteral("hh:mm"));
+    const QCommandLineOption toTimeOption(QStringLiteral("to-time"), tr("Only shows broadcast at or before the given time of day."), QStringLiteral("hh:mm"));
+    const QCommandLineOption minimumDurationOption(QStringLiteral("minimum-duration"), tr("Only shows lasting at least the given duration."), QStringLiteral("hh:mm:ss"));
+    const QCommandLineOption maximumDurationOption(QStringLiteral("maximum-duration"), tr("Only shows lasting at most the given duration."), QStringLiteral("hh:mm:ss"));
+    const QCommandLineOption sortOption(QStringLiteral("sort"), tr("Sort by 'channel', 'topic', 'title', 'date', 'time' or 'duration'."), QStringLiteral("column"), QStringLiteral("channel"));
+    const QCommandLineOption descendingOption(QStringLiteral("descending"), tr("Sort in descending order."));
+    const QCommandLineOption formatOption(QStringLiteral("format"), tr("Print shows as 'tsv' or 'jsonl'."), QStringLiteral("format"), QStringLiteral("tsv"));
+    const QCommandLineOption serveOption(QStringLiteral("serve"), tr("Serve search requests via HTTP on the given local port until terminated."), QStringLiteral("port"));
+
+    parser.addOption(updateOption);
+    parser.addOption(timingsOption);
+    parser.addOption(searchOption);
+    parser.addOption(channelOption);
+    parser.addOption(topicOption);
+    parser.addOption(titleOption);
+    parser.addOption(channelsOption);
+    parser.addOption(fromDateOption);
+    parser.addOption(toDateOption);
+    parser.addOption(fromTimeOption);
+    parser.addOption(toTimeOption);
+    parser.addOption(minimumDurationOption);
+    parser.addOption(maximumDurationOption);
+    parser.addOption(sortOption);
+    parser.addOption(descendingOption);
+    parser.addOption(formatOption);
+    parser.addOption(serveOption);
+
+    parser.process(*this);
+
+    QTextStream error(stderr);
+
+    m_database->open();
+    m_database->waitForOpened();
+
+    if (parser.isSet(updateOption))
+    {
+        const auto value = parser.value(updateOption);
+        auto kind = Updater::Automatic;
+
+        if (value == QLatin1String("full"))
+        {
+            kind = Updater::Full;
+        }
+        else if (value == QLatin1String("partial"))
+        {
+            kind = Updater::Partial;
+        }
+        else if (value != QLatin1String("automatic"))
+        {
+            error << tr("Unknown kind of update: %1").arg(value) << endl;
+            return 1;
+        }
+
+        const auto ok = update(kind);
+
+        if (parser.isSet(timingsOption))
+        {
+            error << QJsonDocument(m_timings->toJson()).toJson();
+        }
+
+        if (!ok)
+        {
+            return 1;
+        }
+    }
+
+    if (parser.isSet(searchOption))
+    {
+        const auto sortValue = parser.value(sortOption).toLatin1();
+        const auto sortColumn = std::find_if(std::begin(sortColumnNames), std::end(sortColumnNames), [&](const char* name)
+        {
+            return sortValue == name;
+        });
+
+        if (sortColumn == std::end(sortColumnNames))
+        {
+            error << tr("Unknown sort column: %1").arg(parser.value(sortOption)) << endl;
+            return 1;
+        }
+
+        const auto format = parser.value(formatOption);
+        const auto json = format == QLatin1String("jsonl");
+
+        if (!json && format != QLatin1String("tsv"))
+        {
+            error << tr("Unknown format: %1").arg(format) << endl;
+            return 1;
+        }
+
+        Filter filter;
+
+        filter.channel = parser.value(channelOption);
+        filter.topic = parser.value(topicOption);
+        filter.title = parser.value(titleOption);
+
+        if (parser.isSet(channelsOption))
+        {
+            filter.channels = parser.value(channelsOption).split(QChar(','), QString::SkipEmptyParts);
+        }
+
+        const auto parseDate = [&](const QCommandLineOption& option, QDate& date)
+        {
+            if (!parser.isSet(option))
+            {
+                return true;
+            }
+
+            date = QDate::fromString(parser.value(option), Qt::ISODate);
+
+            return date.isValid();
+        };
+
+        const auto parseTime = [&](const QCommandLineOption& option, QTime& time)
+        {
+            if (!parser.isSet(option))
+            {
+                return true;
+            }
+
+            time = QTime::fromString(parser.value(option), Qt::ISODate);
+
+            return time.isValid();
+        };
+
+        if (!parseDate(fromDateOption, filter.fromDate) || !parseDate(toDateOption, filter.toDate)
+                || !parseTime(fromTimeOption, filter.fromTime) || !parseTime(toTimeOption, filter.toTime)
+                || !parseTime(minimumDurationOption, filter.minimumDuration) || !parseTime(maximumDurationOption, filter.maximumDuration))
+        {
+            error << tr("Invalid date, time or duration.") << endl;
+            return 1;
+        }
+
+        QFile output;
+
+        if (!output.open(stdout, QIODevice::WriteOnly))
+        {
+            error << output.errorString() << endl;
+            return 1;
+        }
+
+        const auto ids = m_database->query(
+                             filter,
+                             Database::SortColumn(sortColumn - std::begin(sortColumnNames)),
+                             parser.isSet(descendingOption) ? Qt::DescendingOrder : Qt::AscendingOrder);
+
+        // Only the identifiers are kept while the shows are fetched and written one at a time.
+        for (const auto id : ids)
+        {
+            const auto show = m_database->show(id);
+            const auto line = json ? toJsonLine(*show) : toTsv(*show);
+
+            if (output.write(line) != line.size())
+            {
+                error << output.errorString() << endl;
+                return 1;
+            }
+        }
+    }
+
+    if (parser.isSet(serveOption))
+    {
+        bool ok = false;
+        const auto port = parser.value(serveOption).toUShort(&ok);
+
+        Server server(*m_database);
+
+        if (!ok || !server.listen(port))
+        {
+            error << tr("Failed to start query service: %1").arg(server.errorString()) << endl;
+            return 1;
+        }
+
+        return QCoreApplication::exec();
+    }
+
+    return 0;
+}
+
+bool CommandLine::update(const Updater::Kind kind)
+{
+    QEventLoop loop;
+    auto ok = false;
+
+    connect(m_updater, &Updater::completedDatabaseUpdate, &loop, [&]()
+    {
+        ok = true;
+        loop.quit();
+    });
+
+    const auto failed = [&](const QString& message)
+    {
+        QTextStream(stderr) << tr("Failed to update: %1").arg(message) << endl;
+        loop.quit();
+    };
+
+    connect(m_updater, &Updater::failedToUpdateMirrors, &loop, failed);
+    connect(m_updater, &Updater::failedToUpdateDatabase, &loop, failed);
+
+    m_updater->update(kind);
+
+    loop.exec();
+
+    return ok;
+}
+
+} // QMediathekView
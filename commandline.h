@@ -0,0 +1,64 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <QCoreApplication>
+
+#include "updater.h"
+
+namespace QMediathekView
+{
+
+class Settings;
+class Timings;
+class Database;
+
+// Runs updates and searches without a display, e.g. from cron jobs or scripts.
+class CommandLine : public QCoreApplication
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(CommandLine)
+
+public:
+    CommandLine(int& argc, char** argv);
+    ~CommandLine();
+
+    static bool isRequested(int argc, char** argv);
+
+public:
+    int exec();
+
+private:
+    bool update(const Updater::Kind kind);
+
+private:
+    Settings* m_settings;
+    Timings* m_timings;
+    Database* m_database;
+    Updater* m_updater;
+
+};
+
+} // QMediathekView
+
+#endif // COMMANDLINE_H
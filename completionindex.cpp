@@ -0,0 +1,173 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "completionindex.h"
+
+#include <algorithm>
+
+#include "searchkey.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto trigramSize = 3;
+
+quint32 trigramAt(const QString& text, const int position)
+{
+    quint32 hash = 2166136261u;
+
+    for (int index = position; index < position + trigramSize; ++index)
+    {
+        hash = (hash ^ text.at(index).unicode()) * 16777619u;
+    }
+
+    return hash;
+}
+
+template< typename Entries >
+void rankByCount(std::vector< int >& matches, const Entries& entries, const int limit)
+{
+    const auto middle = matches.begin() + std::min< std::size_t >(limit, matches.size());
+
+    std::partial_sort(matches.begin(), middle, matches.end(), [&entries](const int lhs, const int rhs)
+    {
+        return entries[lhs].count > entries[rhs].count;
+    });
+
+    matches.erase(middle, matches.end());
+}
+
+} // anonymous
+
+CompletionIndex::CompletionIndex()
+{
+}
+
+CompletionIndex::CompletionIndex(const QStringList& texts, const QMap< QString, int >& counts)
+{
+    m_entries.reserve(texts.size());
+
+    for (const auto& text : texts)
+    {
+        if (!text.isEmpty())
+        {
+            m_entries.push_back({ text, searchKeyOf(text), counts.value(text) });
+        }
+    }
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs)
+    {
+        return lhs.folded < rhs.folded;
+    });
+
+    for (quint32 entry = 0; entry < m_entries.size(); ++entry)
+    {
+        const auto& folded = m_entries[entry].folded;
+
+        for (int position = 0; position + trigramSize <= folded.size(); ++position)
+        {
+            m_trigrams.push_back(quint64(trigramAt(folded, position)) << 32 | entry);
+        }
+    }
+
+    std::sort(m_trigrams.begin(), m_trigrams.end());
+    m_trigrams.erase(std::unique(m_trigrams.begin(), m_trigrams.end()), m_trigrams.end());
+}
+
+int CompletionIndex::size() const
+{
+    return m_entries.size();
+}
+
+const QString& CompletionIndex::text(const int entry) const
+{
+    return m_entries[entry].text;
+}
+
+std::vector< int > CompletionIndex::complete(const QString& text, const int limit) const
+{
+    std::vector< int > completions;
+
+    const auto folded = searchKeyOf(text);
+
+    if (folded.isEmpty() || limit <= 0)
+    {
+        return completions;
+    }
+
+    const auto begin = std::lower_bound(m_entries.begin(), m_entries.end(), folded, [](const Entry& entry, const QString& folded)
+    {
+        return entry.folded < folded;
+    });
+
+    for (auto entry = begin; entry != m_entries.end() && entry->folded.startsWith(folded); ++entry)
+    {
+        completions.push_back(entry - m_entries.begin());
+    }
+
+    rankByCount(completions, m_entries, limit);
+
+    if (folded.size() < trigramSize || int(completions.size()) == limit)
+    {
+        return completions;
+    }
+
+    // Only the entries sharing the rarest trigram of the text need to be checked.
+    auto candidates = std::make_pair(m_trigrams.end(), m_trigrams.end());
+
+    for (int position = 0; position + trigramSize <= folded.size(); ++position)
+    {
+        const auto trigram = quint64(trigramAt(folded, position)) << 32;
+
+        const auto range = std::make_pair(
+                               std::lower_bound(m_trigrams.begin(), m_trigrams.end(), trigram),
+                               std::upper_bound(m_trigrams.begin(), m_trigrams.end(), trigram | 0xFFFFFFFF));
+
+        if (position == 0 || range.second - range.first < candidates.second - candidates.first)
+        {
+            candidates = range;
+        }
+    }
+
+    std::vector< int > infixes;
+
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+    {
+        const auto& entry = m_entries[*candidate & 0xFFFFFFFF];
+
+        if (!entry.folded.startsWith(folded) && entry.folded.contains(folded))
+        {
+            infixes.push_back(*candidate & 0xFFFFFFFF);
+        }
+    }
+
+    rankByCount(infixes, m_entries, limit - completions.size());
+
+    completions.insert(completions.end(), infixes.begin(), infixes.end());
+
+    return completions;
+}
+
+} // QMediathekView
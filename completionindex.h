@@ -0,0 +1,75 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef COMPLETIONINDEX_H
+#define COMPLETIONINDEX_H
+
+#include <vector>
+
+#include <QMap>
+#include <QStringList>
+
+namespace QMediathekView
+{
+
+/*
+
+Completes channel and topic names as they are typed.
+
+The entries are kept sorted by their search key, i.e. their text folded by case
+and diacritics, so that all entries starting with the typed text form a single
+range found by binary search. Entries merely
+containing the typed text are found via a sorted array of the trigrams of each entry,
+starting from the rarest trigram of the typed text and verifying each candidate.
+
+*/
+class CompletionIndex
+{
+public:
+    CompletionIndex();
+    CompletionIndex(const QStringList& texts, const QMap< QString, int >& counts);
+
+    int size() const;
+    const QString& text(const int entry) const;
+
+    // Yields at most limit entries, those starting with the given text before those containing it,
+    // each ranked by their number of shows.
+    std::vector< int > complete(const QString& text, const int limit) const;
+
+private:
+    struct Entry
+    {
+        QString text;
+        QString folded;
+        int count;
+    };
+
+    std::vector< Entry > m_entries;
+
+    // Each element holds the hash of a trigram in its upper and the entry in its lower half.
+    std::vector< quint64 > m_trigrams;
+
+};
+
+} // QMediathekView
+
+#endif // COMPLETIONINDEX_H
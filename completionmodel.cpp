@@ -0,0 +1,107 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "completionmodel.h"
+
+#include "completionindex.h"
+#include "trace.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto completionLimit = 64;
+
+} // anonymous
+
+CompletionModel::CompletionModel(QObject* parent) : QAbstractListModel(parent)
+{
+}
+
+CompletionModel::~CompletionModel()
+{
+}
+
+int CompletionModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return m_completions.size();
+}
+
+QVariant CompletionModel::data(const QModelIndex& index, int role) const
+{
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+    {
+        return {};
+    }
+
+    if (!index.isValid() || index.row() >= int(m_completions.size()))
+    {
+        return {};
+    }
+
+    return m_index->text(m_completions[index.row()]);
+}
+
+void CompletionModel::setEntries(const QStringList& texts, const QMap< QString, int >& counts)
+{
+    beginResetModel();
+
+    m_texts = texts;
+    m_counts = counts;
+
+    m_index.reset();
+    m_completions.clear();
+
+    endResetModel();
+}
+
+void CompletionModel::complete(const QString& text)
+{
+    TRACE_SCOPE("CompletionModel::complete");
+
+    if (!m_index)
+    {
+        m_index.reset(new CompletionIndex(m_texts, m_counts));
+    }
+
+    auto completions = m_index->complete(text, completionLimit);
+
+    if (m_completions == completions)
+    {
+        return;
+    }
+
+    beginResetModel();
+
+    m_completions.swap(completions);
+
+    endResetModel();
+}
+
+} // QMediathekView
@@ -0,0 +1,66 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef COMPLETIONMODEL_H
+#define COMPLETIONMODEL_H
+
+#include <memory>
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QMap>
+#include <QStringList>
+
+namespace QMediathekView
+{
+
+class CompletionIndex;
+
+// Lists the completions of the text typed so far, building its index only once completions are requested.
+class CompletionModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(CompletionModel)
+
+public:
+    explicit CompletionModel(QObject* parent = 0);
+    ~CompletionModel();
+
+    int rowCount(const QModelIndex& parent) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+public:
+    void setEntries(const QStringList& texts, const QMap< QString, int >& counts);
+    void complete(const QString& text);
+
+private:
+    QStringList m_texts;
+    QMap< QString, int > m_counts;
+
+    std::unique_ptr< CompletionIndex > m_index;
+    std::vector< int > m_completions;
+
+};
+
+} // QMediathekView
+
+#endif // COMPLETIONMODEL_H
@@ -0,0 +1,244 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QHash>
+
+#include <zlib.h>
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+const Bytef* bytesOf(const QByteArray& data)
+{
+    return reinterpret_cast< const Bytef* >(data.constData());
+}
+
+void countWords(QHash< QByteArray, int >& counts, const QByteArray& sample)
+{
+    int previous = -1;
+    int begin = 0;
+
+    for (int end = 0; end <= sample.size(); ++end)
+    {
+        if (end != sample.size() && sample.at(end) != ' ' && sample.at(end) != '\n')
+        {
+            continue;
+        }
+
+        if (end > begin)
+        {
+            // Words are counted including their separator and also in pairs to capture common phrases.
+            ++counts[sample.mid(begin, end + 1 - begin)];
+
+            if (previous >= 0)
+            {
+                ++counts[sample.mid(previous, end + 1 - previous)];
+            }
+
+            previous = begin;
+        }
+
+        begin = end + 1;
+    }
+}
+
+} // anonymous
+
+QByteArray trainDictionary(const std::vector< QByteArray >& samples, const int size)
+{
+    QHash< QByteArray, int > counts;
+
+    for (const auto& sample : samples)
+    {
+        countWords(counts, sample);
+    }
+
+    struct Candidate
+    {
+        QByteArray word;
+        qint64 score;
+    };
+
+    std::vector< Candidate > candidates;
+
+    for (auto iterator = counts.begin(); iterator != counts.end(); ++iterator)
+    {
+        if (iterator.value() > 1)
+        {
+            candidates.push_back({ iterator.key(), qint64(iterator.value()) * iterator.key().size() });
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs)
+    {
+        return lhs.score > rhs.score;
+    });
+
+    std::vector< const Candidate* > chosen;
+    int length = 0;
+
+    for (const auto& candidate : candidates)
+    {
+        if (length + candidate.word.size() > size)
+        {
+            continue;
+        }
+
+        chosen.push_back(&candidate);
+        length += candidate.word.size();
+    }
+
+    // The most valuable words are placed at the end of the dictionary where they are reached using the shortest distances.
+    QByteArray dictionary;
+    dictionary.reserve(length);
+
+    for (auto candidate = chosen.rbegin(); candidate != chosen.rend(); ++candidate)
+    {
+        dictionary.append((*candidate)->word);
+    }
+
+    return dictionary;
+}
+
+quint32 dictionaryIdOf(const QByteArray& dictionary)
+{
+    return adler32(adler32(0, Z_NULL, 0), bytesOf(dictionary), dictionary.size());
+}
+
+quint32 requiredDictionaryOf(const QByteArray& data)
+{
+    constexpr auto presetDictionary = 0x20;
+
+    if (data.size() < 6 || (data.at(1) & presetDictionary) == 0)
+    {
+        return 0;
+    }
+
+    const auto bytes = bytesOf(data);
+
+    return quint32(bytes[2]) << 24 | quint32(bytes[3]) << 16 | quint32(bytes[4]) << 8 | quint32(bytes[5]);
+}
+
+Compressor::Compressor(const QByteArray& dictionary)
+    : m_dictionary(dictionary)
+    , m_stream(new z_stream)
+{
+    std::memset(m_stream.get(), 0, sizeof(z_stream));
+
+    m_initialized = deflateInit(m_stream.get(), Z_BEST_COMPRESSION) == Z_OK;
+}
+
+Compressor::~Compressor()
+{
+    if (m_initialized)
+    {
+        deflateEnd(m_stream.get());
+    }
+}
+
+QByteArray Compressor::compress(const QByteArray& data)
+{
+    if (!m_initialized || data.isEmpty())
+    {
+        return {};
+    }
+
+    // Resetting the stream also drops the dictionary which therefore has to be set for each text.
+    if (deflateReset(m_stream.get()) != Z_OK)
+    {
+        return {};
+    }
+
+    if (!m_dictionary.isEmpty() && deflateSetDictionary(m_stream.get(), bytesOf(m_dictionary), m_dictionary.size()) != Z_OK)
+    {
+        return {};
+    }
+
+    QByteArray compressed(int(deflateBound(m_stream.get(), data.size())), '\0');
+
+    m_stream->next_in = const_cast< Bytef* >(bytesOf(data));
+    m_stream->avail_in = data.size();
+    m_stream->next_out = reinterpret_cast< Bytef* >(compressed.data());
+    m_stream->avail_out = compressed.size();
+
+    if (deflate(m_stream.get(), Z_FINISH) != Z_STREAM_END || m_stream->total_out >= uLong(data.size()))
+    {
+        return {};
+    }
+
+    compressed.resize(m_stream->total_out);
+
+    return compressed;
+}
+
+QByteArray decompress(const QByteArray& data, const QByteArray& dictionary)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(z_stream));
+
+    if (inflateInit(&stream) != Z_OK)
+    {
+        return {};
+    }
+
+    stream.next_in = const_cast< Bytef* >(bytesOf(data));
+    stream.avail_in = data.size();
+
+    QByteArray decompressed;
+    auto result = Z_OK;
+
+    while (result == Z_OK)
+    {
+        const auto offset = decompressed.size();
+        decompressed.resize(offset + qMax(4 * data.size(), 1024));
+
+        stream.next_out = reinterpret_cast< Bytef* >(decompressed.data() + offset);
+        stream.avail_out = decompressed.size() - offset;
+
+        result = inflate(&stream, Z_NO_FLUSH);
+
+        if (result == Z_NEED_DICT)
+        {
+            result = dictionary.isEmpty() ? Z_DATA_ERROR : inflateSetDictionary(&stream, bytesOf(dictionary), dictionary.size());
+        }
+
+        decompressed.resize(stream.total_out);
+    }
+
+    inflateEnd(&stream);
+
+    if (result != Z_STREAM_END)
+    {
+        return {};
+    }
+
+    return decompressed;
+}
+
+} // QMediathekView
@@ -0,0 +1,68 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+
+struct z_stream_s;
+
+namespace QMediathekView
+{
+
+// Short texts compress poorly on their own, but well using a preset dictionary of their common words.
+QByteArray trainDictionary(const std::vector< QByteArray >& samples, const int size = 8 * 1024);
+
+// The compressed data refers to its dictionary using this identifier.
+quint32 dictionaryIdOf(const QByteArray& dictionary);
+
+// Yields zero if the compressed data does not require a dictionary.
+quint32 requiredDictionaryOf(const QByteArray& data);
+
+class Compressor
+{
+public:
+    explicit Compressor(const QByteArray& dictionary);
+    ~Compressor();
+
+    // Yields an empty array if compressing would not save any space.
+    QByteArray compress(const QByteArray& data);
+
+private:
+    Q_DISABLE_COPY(Compressor)
+
+    const QByteArray m_dictionary;
+
+    std::unique_ptr< z_stream_s > m_stream;
+    bool m_initialized;
+
+};
+
+// Yields an empty array if the data is corrupt or the dictionary does not match.
+QByteArray decompress(const QByteArray& data, const QByteArray& dictionary);
+
+} // QMediathekView
+
+#endif // COMPRESSION_H
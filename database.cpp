@@ -21,16 +21,28 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "database.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <QCryptographicHash>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QStandardPaths>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QSqlRecord>
 
 #include <QtConcurrentRun>
 
 #include "settings.h"
 #include "parser.h"
+#include "catalogue.h"
+#include "channelindex.h"
+#include "compression.h"
+#include "searchkey.h"
+#include "timings.h"
+#include "trace.h"
 
 namespace QMediathekView
 {
@@ -40,6 +52,60 @@ namespace
 
 const auto databaseType = QStringLiteral("QSQLITE");
 const auto databaseName = QStringLiteral("database");
+const auto catalogueName = QStringLiteral("catalogue");
+
+constexpr auto busyTimeout = 5 * 1000;
+
+std::atomic< quint64 > nextDatabaseNumber(0);
+std::atomic< quint64 > nextThreadNumber(0);
+
+// Version 1 added the folded search keys of channel, topic and title.
+// Version 2 added the prefixes of website and URL.
+// Version 3 added the filtered columns to the indices of the sort orders.
+constexpr auto schemaVersion = 3;
+
+// Every column a filter may refer to, so that an index containing all of them covers each query.
+const char* const filteredColumns[] = { "channel", "date", "time", "duration", "channelKey", "topicKey", "titleKey" };
+
+// Appends the filtered columns which are not already part of the sort order to its index.
+QString indexDefinition(QStringList columns)
+{
+    for (const auto column : filteredColumns)
+    {
+        const auto name = QString::fromLatin1(column);
+
+        const auto contained = std::any_of(columns.begin(), columns.end(), [&](const QString& definition)
+        {
+            return definition.section(QLatin1Char(' '), 0, 0) == name;
+        });
+
+        if (!contained)
+        {
+            columns.append(name);
+        }
+    }
+
+    return columns.join(QStringLiteral(", "));
+}
+
+// Yields the catalogue only if the sections needed for the given usage are intact, so that SQLite is used otherwise.
+std::shared_ptr< const Catalogue > verified(std::shared_ptr< const Catalogue > catalogue, const Catalogue::Usage usage)
+{
+    if (catalogue && !catalogue->verify(usage))
+    {
+        catalogue.reset();
+    }
+
+    return catalogue;
+}
+
+QString dataFilePath(const QString& name)
+{
+    const auto path = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    QDir().mkpath(path);
+
+    return QDir(path).filePath(name);
+}
 
 class Transaction
 {
@@ -139,6 +205,16 @@ public:
         return m_query.next();
     }
 
+    int numRowsAffected() const
+    {
+        return m_query.numRowsAffected();
+    }
+
+    QVariant lastInsertId() const
+    {
+        return m_query.lastInsertId();
+    }
+
     template< typename Type >
     Type nextValue()
     {
@@ -160,6 +236,8 @@ namespace Queries
 #define DEFINE_QUERY(name, text) const auto name = QStringLiteral(text)
 
 DEFINE_QUERY(truncateShows, "DELETE FROM shows");
+DEFINE_QUERY(truncatePrefixes, "DELETE FROM prefixes");
+DEFINE_QUERY(truncateDictionaries, "DELETE FROM dictionaries");
 
 DEFINE_QUERY(deleteShow, "DELETE FROM shows WHERE key = ?");
 
@@ -172,24 +250,85 @@ DEFINE_QUERY(insertShow,
              " description, website,"
              " url,"
              " urlSmallOffset, urlSmallSuffix,"
-             " urlLargeOffset, urlLargeSuffix)"
-             " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+             " urlLargeOffset, urlLargeSuffix,"
+             " channelKey, topicKey, titleKey,"
+             " websitePrefix, urlPrefix)"
+             " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+DEFINE_QUERY(selectPrefixes, "SELECT id, prefix FROM prefixes");
+
+DEFINE_QUERY(insertPrefix, "INSERT INTO prefixes (prefix) VALUES (?)");
+
+// Full updates remove all dictionaries and partial updates only add one if there is none yet.
+DEFINE_QUERY(selectCurrentDictionary, "SELECT data FROM dictionaries LIMIT 1");
+
+DEFINE_QUERY(selectDictionary, "SELECT data FROM dictionaries WHERE id = ?");
+
+DEFINE_QUERY(insertDictionary, "INSERT OR REPLACE INTO dictionaries (id, data) VALUES (?, ?)");
+
+DEFINE_QUERY(selectTexts, "SELECT id, channel, topic, title FROM shows");
 
+DEFINE_QUERY(updateSearchKeys, "UPDATE shows SET channelKey = ?, topicKey = ?, titleKey = ? WHERE id = ?");
+
+// Website and URL are stored without their prefixes if compressed storage was enabled.
 DEFINE_QUERY(selectShow,
              "SELECT"
              " channel, topic, title,"
              " date, time,"
              " duration,"
-             " description, website,"
-             " url,"
+             " description, ifnull(websitePrefixes.prefix, '') || website,"
+             " ifnull(urlPrefixes.prefix, '') || url,"
              " urlSmallOffset, urlSmallSuffix,"
              " urlLargeOffset, urlLargeSuffix"
+             " FROM shows"
+             " LEFT JOIN prefixes AS websitePrefixes ON websitePrefixes.id = websitePrefix"
+             " LEFT JOIN prefixes AS urlPrefixes ON urlPrefixes.id = urlPrefix"
+             " WHERE shows.id = ?");
+
+// Only the columns shown in the list are read, so that descriptions are neither read from disk nor decompressed.
+DEFINE_QUERY(selectShowRow,
+             "SELECT"
+             " channel, topic, title,"
+             " date, time,"
+             " duration"
              " FROM shows WHERE id = ?");
 
+DEFINE_QUERY(selectShowDetails,
+             "SELECT"
+             " description, ifnull(websitePrefixes.prefix, '') || website,"
+             " ifnull(urlPrefixes.prefix, '') || url,"
+             " urlSmallOffset, urlSmallSuffix,"
+             " urlLargeOffset, urlLargeSuffix"
+             " FROM shows"
+             " LEFT JOIN prefixes AS websitePrefixes ON websitePrefixes.id = websitePrefix"
+             " LEFT JOIN prefixes AS urlPrefixes ON urlPrefixes.id = urlPrefix"
+             " WHERE shows.id = ?");
+
+DEFINE_QUERY(selectShows,
+             "SELECT"
+             " shows.id,"
+             " channel, topic, title,"
+             " date, time,"
+             " duration,"
+             " description, ifnull(websitePrefixes.prefix, '') || website,"
+             " ifnull(urlPrefixes.prefix, '') || url,"
+             " urlSmallOffset, urlSmallSuffix,"
+             " urlLargeOffset, urlLargeSuffix"
+             " FROM shows"
+             " LEFT JOIN prefixes AS websitePrefixes ON websitePrefixes.id = websitePrefix"
+             " LEFT JOIN prefixes AS urlPrefixes ON urlPrefixes.id = urlPrefix"
+             " ORDER BY shows.id");
+
+DEFINE_QUERY(selectChannelIndex, "SELECT channel, topic, count(*) FROM shows GROUP BY channel, topic");
+
+DEFINE_QUERY(selectGeneration, "SELECT ifnull(max(id), 0) FROM shows");
+
 #undef DEFINE_QUERY
 
 }
 
+} // anonymous
+
 QByteArray keyOf(const Show& show)
 {
     QCryptographicHash hash(QCryptographicHash::Md5);
@@ -208,278 +347,985 @@ QByteArray keyOf(const Show& show)
     return hash.result();
 }
 
-void bindTo(Query& query, const QByteArray& key, const Show& show)
+bool Filter::operator==(const Filter& other) const
+{
+    return channel == other.channel && topic == other.topic && title == other.title
+           && channels == other.channels
+           && fromDate == other.fromDate && toDate == other.toDate
+           && fromTime == other.fromTime && toTime == other.toTime
+           && minimumDuration == other.minimumDuration && maximumDuration == other.maximumDuration;
+}
+
+bool Filter::operator!=(const Filter& other) const
+{
+    return !operator==(other);
+}
+
+QString Filter::key() const
+{
+    return QStringList({
+        channel, topic, title,
+        channels.join(QChar('\x1e')),
+        fromDate.toString(Qt::ISODate), toDate.toString(Qt::ISODate),
+        fromTime.toString(Qt::ISODate), toTime.toString(Qt::ISODate),
+        minimumDuration.toString(Qt::ISODate), maximumDuration.toString(Qt::ISODate)
+    }).join(QChar('\x1f'));
+}
+
+namespace
+{
+
+struct SearchKeys
+{
+    QString channel;
+    QString topic;
+    QString title;
+};
+
+// The description is either text or compressed data and website and URL may lack their prefixes.
+struct StoredTexts
+{
+    QVariant description;
+
+    QVariant websitePrefix;
+    QString website;
+
+    QVariant urlPrefix;
+    QString url;
+};
+
+void bindTo(Query& query, const QByteArray& key, const Show& show, const SearchKeys& keys, const StoredTexts& texts)
 {
     query << key
           << show.channel << show.topic << show.title
           << show.date.toJulianDay() << show.time.msecsSinceStartOfDay()
           << show.duration.msecsSinceStartOfDay()
-          << show.description << show.website
-          << show.url
+          << texts.description << texts.website
+          << texts.url
           << show.urlSmallOffset << show.urlSmallSuffix
-          << show.urlLargeOffset << show.urlLargeSuffix;
+          << show.urlLargeOffset << show.urlLargeSuffix
+          << keys.channel << keys.topic << keys.title
+          << texts.websitePrefix << texts.urlPrefix;
 }
 
-class FullUpdate : public Processor
+void readFrom(Query& query, ShowRow& show)
 {
-public:
-    FullUpdate(QSqlDatabase& database)
-        : m_transaction(database)
-        , m_insertShow(database)
-    {
-        Query(database).exec(Queries::truncateShows);
-        m_insertShow.prepare(Queries::insertShow);
-    }
+    show.channel = query.nextValue< QString >();
+    show.topic = query.nextValue< QString >();
+    show.title = query.nextValue< QString >();
 
-    void operator()(const Show& show) override
-    {
-        const auto key = keyOf(show);
+    show.date =  QDate::fromJulianDay(query.nextValue< qint64 >());
+    show.time = QTime::fromMSecsSinceStartOfDay(query.nextValue< int >());
 
-        bindTo(m_insertShow, key, show);
+    show.duration = QTime::fromMSecsSinceStartOfDay(query.nextValue< int >());
+}
 
-        m_insertShow.exec();
-    }
+template< typename Decompress >
+void readFrom(Query& query, ShowDetails& show, Decompress decompress)
+{
+    show.description = decompress(query.nextValue< QVariant >());
+    show.website = query.nextValue< QString >();
 
-    void commit()
-    {
-        m_transaction.commit();
-    }
+    show.url = query.nextValue< QString >();
 
-private:
-    Transaction m_transaction;
-    Query m_insertShow;
+    show.urlSmallOffset = query.nextValue< unsigned short >();
+    show.urlSmallSuffix = query.nextValue< QString >();
 
-};
+    show.urlLargeOffset = query.nextValue< unsigned short >();
+    show.urlLargeSuffix = query.nextValue< QString >();
+}
 
-class PartialUpdate : public Processor
+template< typename Decompress >
+void readFrom(Query& query, Show& show, Decompress decompress)
 {
-public:
-    PartialUpdate(QSqlDatabase& database)
-        : m_transaction(database)
-        , m_deleteShow(database)
-        , m_insertShow(database)
-    {
-        m_deleteShow.prepare(Queries::deleteShow);
-        m_insertShow.prepare(Queries::insertShow);
-    }
+    readFrom(query, static_cast< ShowRow& >(show));
+    readFrom(query, static_cast< ShowDetails& >(show), decompress);
+}
 
-    void operator()(const Show& show) override
+// Converts the arena-backed records into shows while sharing the strings and search keys
+// for channel and topic which are usually repeated by consecutive entries.
+class Converter
+{
+public:
+    const Show& operator()(const ShowRecord& record)
     {
-        const auto key = keyOf(show);
+        if (intern(m_channel, m_show.channel, record.channel))
+        {
+            m_keys.channel = searchKeyOf(m_show.channel);
+        }
 
-        m_deleteShow << key;
+        if (intern(m_topic, m_show.topic, record.topic))
+        {
+            m_keys.topic = searchKeyOf(m_show.topic);
+        }
 
-        m_deleteShow.exec();
+        m_show.title = record.title.toString();
+        m_keys.title = searchKeyOf(m_show.title);
 
-        bindTo(m_insertShow, key, show);
+        m_show.date = record.date;
+        m_show.time = record.time;
 
-        m_insertShow.exec();
-    }
+        m_show.duration = record.duration;
 
-    void commit()
-    {
-        m_transaction.commit();
-    }
+        m_show.description = record.description.toString();
+        m_show.website = record.website.toString();
 
-private:
-    Transaction m_transaction;
-    Query m_deleteShow;
-    Query m_insertShow;
+        m_show.url = record.url.toString();
 
-};
+        m_show.urlSmallOffset = record.urlSmallOffset;
+        m_show.urlSmallSuffix = record.urlSmallSuffix.toString();
 
-} // anonymous
+        m_show.urlLargeOffset = record.urlLargeOffset;
+        m_show.urlLargeSuffix = record.urlLargeSuffix.toString();
 
-Database::Database(Settings& settings, QObject* parent)
-    : QObject(parent)
-    , m_settings(settings)
-    , m_database(QSqlDatabase::addDatabase(databaseType))
-{
-    const auto path = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
-    QDir().mkpath(path);
-    m_database.setDatabaseName(QDir(path).filePath(databaseName));
+        return m_show;
+    }
 
-    if (!m_database.open())
+    const SearchKeys& keys() const
     {
-        qDebug() << m_database.lastError();
-        return;
+        return m_keys;
     }
 
-    try
-    {
-        Query query(m_database);
+private:
+    Show m_show;
+    SearchKeys m_keys;
 
-        query.exec(QStringLiteral(
-                       "CREATE TABLE IF NOT EXISTS shows ("
-                       " id INTEGER PRIMARY KEY AUTOINCREMENT,"
-                       " key BLOB,"
-                       " channel TEXT NOCASE,"
-                       " topic TEXT NOCASE,"
-                       " title TEXT NOCASE,"
-                       " date INTEGER,"
-                       " time INTEGER,"
-                       " duration INTEGER,"
-                       " description TEXT,"
-                       " website TEXT,"
-                       " url TEXT,"
-                       " urlSmallOffset INTEGER,"
-                       " urlSmallSuffix TEXT,"
-                       " urlLargeOffset INTEGER,"
-                       " urlLargeSuffix TEXT)"));
-
-        query.exec(QStringLiteral("CREATE UNIQUE INDEX IF NOT EXISTS showsByKey ON shows (key)"));
-
-        query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByChannel ON shows (channel)"));
-        query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByTopic ON shows (topic)"));
-        query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByTitle ON shows (title)"));
-
-        query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByDateAndTime ON shows (date DESC, time DESC)"));
+    std::string m_channel;
+    std::string m_topic;
 
-    }
-    catch (QSqlError& error)
+    static bool intern(std::string& bytes, QString& string, const Text& text)
     {
-        qDebug() << error;
-    }
-}
-
-Database::~Database()
-{
-    m_update.waitForFinished();
-}
-
-void Database::fullUpdate(const QByteArray& data)
-{
-    update< FullUpdate >(data);
-}
+        if (bytes.size() != std::size_t(text.size) || bytes.compare(0, bytes.size(), text.data, text.size) != 0)
+        {
+            bytes.assign(text.data, text.size);
+            string = text.toString();
 
+            return true;
+        }
 
-void Database::partialUpdate(const QByteArray& data)
-{
-    update< PartialUpdate >(data);
-}
+        return false;
+    }
 
+};
 
-template< typename Processor >
-void Database::update(const QByteArray& data)
+// Compresses descriptions using a dictionary trained on the first batch of shows if there is none yet
+// and replaces the prefixes of website and URL, i.e. everything up to the last slash, by a reference.
+class Compaction
 {
-    if (m_update.isRunning())
+public:
+    Compaction(QSqlDatabase& database, const bool enabled)
+        : m_database(database)
+        , m_enabled(enabled)
+        , m_prepared(false)
+        , m_insertPrefix(database)
     {
-        return;
     }
 
-    m_update = QtConcurrent::run([this, data]()
+    void prepare(const std::vector< ShowRecord >& shows)
     {
-        try
+        if (!m_enabled || m_prepared)
         {
-            Processor processor(m_database);
+            return;
+        }
 
-            if (!parse(data, processor))
-            {
-                emit failedToUpdate(tr("Could not parse data."));
-                return;
-            }
+        m_prepared = true;
 
-            Query(m_database).exec(QStringLiteral("ANALYZE"));
+        Query query(m_database);
 
-            processor.commit();
+        query.exec(Queries::selectPrefixes);
 
-            m_settings.setDatabaseUpdatedOn();
+        while (query.nextRecord())
+        {
+            const auto id = query.nextValue< qint64 >();
+            const auto prefix = query.nextValue< QString >();
 
-            emit updated();
+            m_prefixes.insert(prefix, id);
         }
-        catch (QSqlError& error)
+
+        query.exec(Queries::selectCurrentDictionary);
+
+        auto dictionary = query.nextRecord() ? query.nextValue< QByteArray >() : QByteArray();
+
+        if (dictionary.isEmpty())
         {
-            qDebug() << error;
+            std::vector< QByteArray > samples;
+            samples.reserve(shows.size());
+
+            for (const auto& record : shows)
+            {
+                samples.emplace_back(record.description.data, record.description.size);
+            }
+
+            dictionary = trainDictionary(samples);
+
+            if (!dictionary.isEmpty())
+            {
+                query.prepare(Queries::insertDictionary);
+                query << qint64(dictionaryIdOf(dictionary)) << dictionary;
+                query.exec();
+            }
         }
-    });
-}
 
-QVector< quintptr > Database::query(
-    const QString& channel, const QString& topic, const QString& title,
-    const SortColumn sortColumn, const Qt::SortOrder sortOrder) const
-{
-    QVector< quintptr > id;
+        m_compressor.reset(new Compressor(dictionary));
 
-    QString sortOrderClause;
+        m_insertPrefix.prepare(Queries::insertPrefix);
+    }
 
-    switch (sortOrder)
+    const StoredTexts& operator()(const Show& show)
     {
-    default:
-    case Qt::AscendingOrder:
-        break;
-    case Qt::DescendingOrder:
-        sortOrderClause = QStringLiteral("DESC");
-        break;
-    }
+        m_texts.description = compress(show.description);
 
-    QString sortClause;
+        split(show.website, m_texts.websitePrefix, m_texts.website);
+        split(show.url, m_texts.urlPrefix, m_texts.url);
 
-    switch (sortColumn)
-    {
-    default:
-    case SortChannel:
-        sortClause = QStringLiteral("channel %1, date DESC, time DESC").arg(sortOrderClause);
-        break;
-    case SortTopic:
-        sortClause = QStringLiteral("topic %1, date DESC, time DESC").arg(sortOrderClause);
-        break;
-    case SortTitle:
-        sortClause = QStringLiteral("title %1, date DESC, time DESC").arg(sortOrderClause);
-        break;
-    case SortDate:
-        sortClause = QStringLiteral("date %1").arg(sortOrderClause);
-        break;
-    case SortTime:
-        sortClause = QStringLiteral("time %1").arg(sortOrderClause);
-        break;
-    case SortDuration:
-        sortClause = QStringLiteral("duration %1").arg(sortOrderClause);
-        break;
+        return m_texts;
     }
 
-    const auto channelFilterClause = channel.isEmpty() ? QStringLiteral("ifnull(1, ?)")
-                                     : QStringLiteral("channel LIKE ('%' || ? || '%')");
+private:
+    Q_DISABLE_COPY(Compaction)
+
+    QSqlDatabase& m_database;
+    const bool m_enabled;
+    bool m_prepared;
 
-    const auto topicFilterClause = topic.isEmpty() ? QStringLiteral("ifnull(1, ?)")
-                                   : QStringLiteral("topic LIKE ('%' || ? || '%')");
+    std::unique_ptr< Compressor > m_compressor;
 
-    const auto titleFilterCaluse = title.isEmpty() ? QStringLiteral("ifnull(1, ?)")
-                                   : QStringLiteral("title LIKE ('%' || ? || '%')");
+    QHash< QString, qint64 > m_prefixes;
+    Query m_insertPrefix;
 
-    try
+    StoredTexts m_texts;
+
+    QVariant compress(const QString& text)
     {
-        Query query(m_database);
+        if (!m_compressor)
+        {
+            return text;
+        }
 
-        query.prepare(QStringLiteral("SELECT id FROM shows WHERE %1 AND %2 AND %3 ORDER BY %4")
-                      .arg(channelFilterClause)
-                      .arg(topicFilterClause)
-                      .arg(titleFilterCaluse)
-                      .arg(sortClause));
+        const auto compressed = m_compressor->compress(text.toUtf8());
 
-        query << channel << topic << title;
+        return compressed.isEmpty() ? QVariant(text) : QVariant(compressed);
+    }
 
-        query.exec();
+    void split(const QString& text, QVariant& prefixId, QString& suffix)
+    {
+        const auto length = m_enabled ? text.lastIndexOf(QLatin1Char('/')) + 1 : 0;
 
-        while (query.nextRecord())
+        if (length <= 0)
         {
-            id.append(query.nextValue< quintptr >());
+            prefixId = QVariant();
+            suffix = text;
+            return;
         }
-    }
-    catch (QSqlError& error)
-    {
-        qDebug() << error;
-    }
 
-    return id;
-}
+        const auto prefix = text.left(length);
 
-std::unique_ptr< Show > Database::show(const quintptr id) const
-{
-    std::unique_ptr< Show > show(new Show);
+        auto iterator = m_prefixes.find(prefix);
 
-    try
+        if (iterator == m_prefixes.end())
+        {
+            m_insertPrefix << prefix;
+            m_insertPrefix.exec();
+
+            iterator = m_prefixes.insert(prefix, m_insertPrefix.lastInsertId().toLongLong());
+        }
+
+        prefixId = iterator.value();
+        suffix = text.mid(length);
+    }
+
+};
+
+class Update : public Processor
+{
+public:
+    Update(QSqlDatabase& database, const ChannelIndex& channelIndex, const bool compressed)
+        : m_channelIndex(channelIndex)
+        , m_compact(database, compressed)
+    {
+    }
+
+    void operator()(const std::vector< ShowRecord >& shows) override
+    {
+        TRACE_SCOPE("Update::operator()");
+
+        QElapsedTimer timer;
+        timer.start();
+
+        m_compact.prepare(shows);
+
+        for (const auto& record : shows)
+        {
+            const auto& show = m_convert(record);
+
+            process(show, m_convert.keys(), m_compact(show));
+        }
+
+        m_rows += shows.size();
+        m_nanoseconds += timer.nsecsElapsed();
+    }
+
+    qint64 rows() const
+    {
+        return m_rows;
+    }
+
+    qint64 nanoseconds() const
+    {
+        return m_nanoseconds;
+    }
+
+    const ChannelIndex& channelIndex() const
+    {
+        return m_channelIndex;
+    }
+
+protected:
+    virtual void process(const Show& show, const SearchKeys& keys, const StoredTexts& texts) = 0;
+
+    ChannelIndex m_channelIndex;
+
+private:
+    Converter m_convert;
+    Compaction m_compact;
+
+    qint64 m_rows = 0;
+    qint64 m_nanoseconds = 0;
+
+};
+
+class FullUpdate : public Update
+{
+public:
+    FullUpdate(QSqlDatabase& database, const ChannelIndex&, const bool compressed)
+        : Update(database, ChannelIndex(), compressed)
+        , m_transaction(database)
+        , m_insertShow(database)
+    {
+        Query query(database);
+        query.exec(Queries::truncateShows);
+        query.exec(Queries::truncatePrefixes);
+        query.exec(Queries::truncateDictionaries);
+
+        m_insertShow.prepare(Queries::insertShow);
+    }
+
+    void commit()
+    {
+        m_transaction.commit();
+    }
+
+protected:
+    void process(const Show& show, const SearchKeys& keys, const StoredTexts& texts) override
+    {
+        const auto key = keyOf(show);
+
+        bindTo(m_insertShow, key, show, keys, texts);
+
+        m_insertShow.exec();
+
+        if (m_insertShow.numRowsAffected() > 0)
+        {
+            m_channelIndex.insert(show.channel, show.topic);
+        }
+    }
+
+private:
+    Transaction m_transaction;
+    Query m_insertShow;
+
+};
+
+class PartialUpdate : public Update
+{
+public:
+    PartialUpdate(QSqlDatabase& database, const ChannelIndex& channelIndex, const bool compressed)
+        : Update(database, channelIndex, compressed)
+        , m_transaction(database)
+        , m_deleteShow(database)
+        , m_insertShow(database)
+    {
+        m_deleteShow.prepare(Queries::deleteShow);
+        m_insertShow.prepare(Queries::insertShow);
+    }
+
+    void commit()
+    {
+        m_transaction.commit();
+    }
+
+protected:
+    void process(const Show& show, const SearchKeys& keys, const StoredTexts& texts) override
+    {
+        const auto key = keyOf(show);
+
+        m_deleteShow << key;
+
+        m_deleteShow.exec();
+
+        // Since the key covers channel and topic, a replaced show leaves the counts unchanged.
+        if (m_deleteShow.numRowsAffected() > 0)
+        {
+            m_channelIndex.remove(show.channel, show.topic);
+        }
+
+        bindTo(m_insertShow, key, show, keys, texts);
+
+        m_insertShow.exec();
+
+        if (m_insertShow.numRowsAffected() > 0)
+        {
+            m_channelIndex.insert(show.channel, show.topic);
+        }
+    }
+
+private:
+    Transaction m_transaction;
+    Query m_deleteShow;
+    Query m_insertShow;
+
+};
+
+} // anonymous
+
+Database::Database(Settings& settings, Timings& timings, QObject* parent)
+    : QObject(parent)
+    , m_settings(settings)
+    , m_timings(timings)
+    , m_connectionName(QStringLiteral("database-%1").arg(nextDatabaseNumber++))
+    , m_isOpen(false)
+    , m_queryCache(settings.queryCacheSize() * 1024 * 1024)
+    , m_generation(0)
+{
+    // Opening and updating share a single thread which is kept alive, so that they share a single connection as well.
+    m_worker.setMaxThreadCount(1);
+    m_worker.setExpiryTimeout(-1);
+}
+
+Database::~Database()
+{
+    m_open.waitForFinished();
+    m_update.waitForFinished();
+
+    QMutexLocker locker(&m_connectionsLock);
+
+    for (const auto& name : m_connections)
+    {
+        QSqlDatabase::removeDatabase(name);
+    }
+}
+
+QSqlDatabase Database::connection() const
+{
+    static thread_local const auto threadNumber = nextThreadNumber++;
+
+    const auto name = QStringLiteral("%1-%2").arg(m_connectionName).arg(threadNumber);
+
+    if (QSqlDatabase::contains(name))
+    {
+        return QSqlDatabase::database(name);
+    }
+
+    auto database = QSqlDatabase::addDatabase(databaseType, name);
+    database.setDatabaseName(dataFilePath(databaseName));
+    database.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(busyTimeout));
+
+    {
+        QMutexLocker locker(&m_connectionsLock);
+
+        m_connections.append(name);
+    }
+
+    if (!database.open())
+    {
+        throw database.lastError();
+    }
+
+    return database;
+}
+
+void Database::open()
+{
+    m_open = QtConcurrent::run(&m_worker, [this]()
+    {
+        TRACE_SCOPE("Database::open");
+
+        QSqlDatabase database;
+
+        try
+        {
+            database = connection();
+        }
+        catch (QSqlError& error)
+        {
+            qDebug() << error;
+            return;
+        }
+
+        try
+        {
+            Query query(database);
+
+            // Readers using their own connections are neither blocked by nor see the transaction of an update.
+            query.exec(QStringLiteral("PRAGMA journal_mode = WAL"));
+
+            query.exec(QStringLiteral("PRAGMA user_version"));
+
+            const auto version = query.nextRecord() ? query.nextValue< int >() : 0;
+
+            query.exec(QStringLiteral(
+                           "CREATE TABLE IF NOT EXISTS shows ("
+                           " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                           " key BLOB,"
+                           " channel TEXT,"
+                           " topic TEXT,"
+                           " title TEXT,"
+                           " date INTEGER,"
+                           " time INTEGER,"
+                           " duration INTEGER,"
+                           " description TEXT,"
+                           " website TEXT,"
+                           " url TEXT,"
+                           " urlSmallOffset INTEGER,"
+                           " urlSmallSuffix TEXT,"
+                           " urlLargeOffset INTEGER,"
+                           " urlLargeSuffix TEXT,"
+                           " channelKey TEXT,"
+                           " topicKey TEXT,"
+                           " titleKey TEXT,"
+                           " websitePrefix INTEGER,"
+                           " urlPrefix INTEGER)"));
+
+            query.exec(QStringLiteral("CREATE TABLE IF NOT EXISTS prefixes (id INTEGER PRIMARY KEY, prefix TEXT UNIQUE)"));
+
+            // Dictionaries are identified by their checksum which is also recorded by the data compressed using them.
+            query.exec(QStringLiteral("CREATE TABLE IF NOT EXISTS dictionaries (id INTEGER PRIMARY KEY, data BLOB)"));
+
+            if (version < schemaVersion)
+            {
+                migrate(version);
+            }
+
+            query.exec(QStringLiteral("CREATE UNIQUE INDEX IF NOT EXISTS showsByKey ON shows (key)"));
+
+            // Each sort order is served by an index which also contains the row identifier and every filtered column,
+            // so that the query never needs to sort and never needs to visit the table itself, not even to match substrings
+            // of the search keys. This costs storing the search keys once per index.
+            // Since textual columns are always tie-broken by date and time in descending order,
+            // ascending and descending sorts need separate indices.
+            query.exec(QStringLiteral("DROP INDEX IF EXISTS showsByChannel"));
+            query.exec(QStringLiteral("DROP INDEX IF EXISTS showsByTopic"));
+            query.exec(QStringLiteral("DROP INDEX IF EXISTS showsByTitle"));
+
+            for (const auto column : { "channel", "topic", "title" })
+            {
+                const auto name = QString::fromLatin1(column);
+                const auto capitalized = name.left(1).toUpper() + name.mid(1);
+
+                query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsBy%1Ascending ON shows (%2)")
+                           .arg(capitalized, indexDefinition({ name + QStringLiteral(" ASC"), QStringLiteral("date DESC"), QStringLiteral("time DESC") })));
+                query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsBy%1Descending ON shows (%2)")
+                           .arg(capitalized, indexDefinition({ name + QStringLiteral(" DESC"), QStringLiteral("date DESC"), QStringLiteral("time DESC") })));
+            }
+
+            query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByDateAndTime ON shows (%1)")
+                       .arg(indexDefinition({ QStringLiteral("date DESC"), QStringLiteral("time DESC") })));
+            query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByTime ON shows (%1)").arg(indexDefinition({ QStringLiteral("time") })));
+            query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS showsByDuration ON shows (%1)").arg(indexDefinition({ QStringLiteral("duration") })));
+
+            // Superseded by the search keys contained in the indices of the sort orders.
+            query.exec(QStringLiteral("DROP INDEX IF EXISTS showsBySearchKeys"));
+
+            loadChannelIndex();
+
+            if (m_settings.inMemoryCatalogue())
+            {
+                openCatalogue();
+            }
+            else
+            {
+                dropCatalogue();
+            }
+        }
+        catch (QSqlError& error)
+        {
+            qDebug() << error;
+        }
+
+        m_isOpen = true;
+
+        emit opened();
+    });
+}
+
+void Database::waitForOpened() const
+{
+    m_open.waitForFinished();
+}
+
+bool Database::isOpen() const
+{
+    return m_isOpen;
+}
+
+void Database::fullUpdate(const QByteArray& data)
+{
+    update< FullUpdate >(data);
+}
+
+
+void Database::partialUpdate(const QByteArray& data)
+{
+    update< PartialUpdate >(data);
+}
+
+
+template< typename Processor >
+void Database::update(const QByteArray& data)
+{
+    if (m_update.isRunning())
+    {
+        return;
+    }
+
+    m_update = QtConcurrent::run(&m_worker, [this, data]()
+    {
+        // An update requested right after starting up has to wait for the database to be opened.
+        waitForOpened();
+
+        if (!m_isOpen)
+        {
+            emit failedToUpdate(tr("Could not open database."));
+            return;
+        }
+
+        try
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            const auto channelIndex = this->channelIndex();
+
+            auto database = connection();
+
+            Processor processor(database, channelIndex ? *channelIndex : ChannelIndex(), m_settings.compressedStorage());
+
+            m_timings.record(QStringLiteral("prepare"), timer.nsecsElapsed());
+            timer.restart();
+
+            if (!parse(data, processor))
+            {
+                emit failedToUpdate(tr("Could not parse data."));
+                return;
+            }
+
+            m_timings.record(QStringLiteral("parse"), timer.nsecsElapsed() - processor.nanoseconds(), data.size(), processor.rows());
+            m_timings.record(QStringLiteral("insert"), processor.nanoseconds(), 0, processor.rows());
+            timer.restart();
+
+            Query(database).exec(QStringLiteral("ANALYZE"));
+
+            m_timings.record(QStringLiteral("analyze"), timer.nsecsElapsed());
+            timer.restart();
+
+            processor.commit();
+
+            m_timings.record(QStringLiteral("commit"), timer.nsecsElapsed());
+
+            setChannelIndex(processor.channelIndex());
+
+            if (m_settings.inMemoryCatalogue())
+            {
+                timer.restart();
+
+                loadCatalogue();
+
+                m_timings.record(QStringLiteral("catalogue"), timer.nsecsElapsed(), 0, catalogue()->size());
+            }
+            else
+            {
+                dropCatalogue();
+            }
+
+            m_settings.setDatabaseUpdatedOn();
+
+            {
+                QMutexLocker locker(&m_queryCacheLock);
+
+                ++m_generation;
+                m_queryCache.clear();
+            }
+
+            emit updated();
+        }
+        catch (QSqlError& error)
+        {
+            qDebug() << error;
+
+            emit failedToUpdate(error.text());
+        }
+    });
+}
+
+QVector< quintptr > Database::query(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder) const
+{
+    TRACE_SCOPE("Database::query");
+
+    if (!m_isOpen)
+    {
+        return {};
+    }
+
+    const auto key = QStringList({ filter.key(), QString::number(sortColumn), QString::number(sortOrder) }).join(QChar('\x1f'));
+
+    quint64 generation;
+
+    {
+        QMutexLocker locker(&m_queryCacheLock);
+
+        if (const auto cached = m_queryCache.object(key))
+        {
+            return *cached;
+        }
+
+        generation = m_generation;
+    }
+
+    const auto id = fetchQuery(filter, sortColumn, sortOrder);
+
+    const auto cost = key.size() * int(sizeof(QChar)) + id.size() * int(sizeof(quintptr));
+
+    QMutexLocker locker(&m_queryCacheLock);
+
+    // The results are outdated if an update was committed in the meantime.
+    if (generation == m_generation && cost <= m_queryCache.maxCost())
+    {
+        m_queryCache.insert(key, new QVector< quintptr >(id), cost);
+    }
+
+    return id;
+}
+
+QVector< quintptr > Database::fetchQuery(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder) const
+{
+    if (const auto catalogue = verified(this->catalogue(), Catalogue::Usage::Query))
+    {
+        return catalogue->query(filter, sortColumn, sortOrder);
+    }
+
+    QVector< quintptr > id;
+
+    QVariantList values;
+    const auto statement = queryStatement(filter, sortColumn, sortOrder, values);
+
+    try
+    {
+        auto database = connection();
+        Query query(database);
+
+        query.prepare(statement);
+
+        for (const auto& value : values)
+        {
+            query << value;
+        }
+
+        query.exec();
+
+        while (query.nextRecord())
+        {
+            id.append(query.nextValue< quintptr >());
+        }
+    }
+    catch (QSqlError& error)
+    {
+        qDebug() << error;
+    }
+
+    return id;
+}
+
+QStringList Database::explainQuery(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder) const
+{
+    QStringList plan;
+
+    if (!m_isOpen)
+    {
+        return plan;
+    }
+
+    QVariantList values;
+    const auto statement = queryStatement(filter, sortColumn, sortOrder, values);
+
+    try
+    {
+        auto database = connection();
+        Query query(database);
+
+        query.prepare(QStringLiteral("EXPLAIN QUERY PLAN %1").arg(statement));
+
+        for (const auto& value : values)
+        {
+            query << value;
+        }
+
+        query.exec();
+
+        while (query.nextRecord())
+        {
+            // Only the detail column following the identifiers of the step is of interest.
+            query.nextValue< int >();
+            query.nextValue< int >();
+            query.nextValue< int >();
+
+            plan.append(query.nextValue< QString >());
+        }
+    }
+    catch (QSqlError& error)
+    {
+        qDebug() << error;
+    }
+
+    return plan;
+}
+
+QString Database::queryStatement(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder, QVariantList& values)
+{
+    QString sortOrderClause;
+
+    switch (sortOrder)
+    {
+    default:
+    case Qt::AscendingOrder:
+        break;
+    case Qt::DescendingOrder:
+        sortOrderClause = QStringLiteral("DESC");
+        break;
+    }
+
+    QString sortClause;
+
+    switch (sortColumn)
+    {
+    default:
+    case SortChannel:
+        sortClause = QStringLiteral("channel %1, date DESC, time DESC").arg(sortOrderClause);
+        break;
+    case SortTopic:
+        sortClause = QStringLiteral("topic %1, date DESC, time DESC").arg(sortOrderClause);
+        break;
+    case SortTitle:
+        sortClause = QStringLiteral("title %1, date DESC, time DESC").arg(sortOrderClause);
+        break;
+    case SortDate:
+        sortClause = QStringLiteral("date %1").arg(sortOrderClause);
+        break;
+    case SortTime:
+        sortClause = QStringLiteral("time %1").arg(sortOrderClause);
+        break;
+    case SortDuration:
+        sortClause = QStringLiteral("duration %1").arg(sortOrderClause);
+        break;
+    }
+
+    QStringList filterClauses;
+
+    // Substrings are matched against the search keys which are already folded.
+    // Since instr cannot seek an index, these filters are evaluated on the entries of the index of the sort order which contains the keys.
+    const auto addContains = [&](const QString& column, const QString& value)
+    {
+        if (!value.isEmpty())
+        {
+            filterClauses.append(QStringLiteral("instr(%1, ?) > 0").arg(column));
+            values.append(searchKeyOf(value));
+        }
+    };
+
+    addContains(QStringLiteral("channelKey"), filter.channel);
+    addContains(QStringLiteral("topicKey"), filter.topic);
+    addContains(QStringLiteral("titleKey"), filter.title);
+
+    // Exact channels and date ranges are written such that the indices on channel and on date and time apply.
+    if (!filter.channels.isEmpty())
+    {
+        auto placeholders = QStringLiteral("?, ").repeated(filter.channels.size());
+        placeholders.chop(2);
+
+        filterClauses.append(QStringLiteral("channel IN (%1)").arg(placeholders));
+
+        for (const auto& channel : filter.channels)
+        {
+            values.append(channel);
+        }
+    }
+
+    if (filter.fromDate.isValid() || filter.toDate.isValid())
+    {
+        filterClauses.append(QStringLiteral("date BETWEEN ? AND ?"));
+        values.append(filter.fromDate.isValid() ? filter.fromDate.toJulianDay() : qint64(0));
+        values.append(filter.toDate.isValid() ? filter.toDate.toJulianDay() : std::numeric_limits< qint64 >::max());
+    }
+
+    if (filter.fromTime.isValid() && filter.toTime.isValid() && filter.fromTime > filter.toTime)
+    {
+        filterClauses.append(QStringLiteral("(time >= ? OR time <= ?)"));
+        values.append(filter.fromTime.msecsSinceStartOfDay());
+        values.append(filter.toTime.msecsSinceStartOfDay());
+    }
+    else
     {
-        Query query(m_database);
+        if (filter.fromTime.isValid())
+        {
+            filterClauses.append(QStringLiteral("time >= ?"));
+            values.append(filter.fromTime.msecsSinceStartOfDay());
+        }
+
+        if (filter.toTime.isValid())
+        {
+            filterClauses.append(QStringLiteral("time <= ?"));
+            values.append(filter.toTime.msecsSinceStartOfDay());
+        }
+    }
+
+    if (filter.minimumDuration.isValid())
+    {
+        filterClauses.append(QStringLiteral("duration >= ?"));
+        values.append(filter.minimumDuration.msecsSinceStartOfDay());
+    }
+
+    if (filter.maximumDuration.isValid())
+    {
+        filterClauses.append(QStringLiteral("duration <= ?"));
+        values.append(filter.maximumDuration.msecsSinceStartOfDay());
+    }
+
+    const auto filterClause = filterClauses.isEmpty() ? QStringLiteral("1") : filterClauses.join(QStringLiteral(" AND "));
+
+    return QStringLiteral("SELECT id FROM shows WHERE %1 ORDER BY %2")
+           .arg(filterClause)
+           .arg(sortClause);
+}
+
+std::unique_ptr< Show > Database::show(const quintptr id) const
+{
+    TRACE_SCOPE("Database::show");
+
+    if (const auto catalogue = verified(this->catalogue(), Catalogue::Usage::Show))
+    {
+        return catalogue->show(id);
+    }
+
+    std::unique_ptr< Show > show(new Show);
+
+    if (!m_isOpen)
+    {
+        return show;
+    }
+
+    try
+    {
+        auto database = connection();
+        Query query(database);
 
         query.prepare(Queries::selectShow);
 
@@ -489,25 +1335,93 @@ std::unique_ptr< Show > Database::show(const quintptr id) const
 
         if (query.nextRecord())
         {
-            show->channel = query.nextValue< QString >();
-            show->topic = query.nextValue< QString >();
-            show->title = query.nextValue< QString >();
+            readFrom(query, *show, [this](const QVariant& description)
+            {
+                return this->description(description);
+            });
+        }
+    }
+    catch (QSqlError& error)
+    {
+        qDebug() << error;
+    }
+
+    return show;
+}
+
+std::unique_ptr< ShowRow > Database::showRow(const quintptr id) const
+{
+    TRACE_SCOPE("Database::showRow");
+
+    if (const auto catalogue = verified(this->catalogue(), Catalogue::Usage::Row))
+    {
+        return catalogue->showRow(id);
+    }
+
+    std::unique_ptr< ShowRow > show(new ShowRow);
+
+    if (!m_isOpen)
+    {
+        return show;
+    }
+
+    try
+    {
+        auto database = connection();
+        Query query(database);
+
+        query.prepare(Queries::selectShowRow);
+
+        query << id;
+
+        query.exec();
+
+        if (query.nextRecord())
+        {
+            readFrom(query, *show);
+        }
+    }
+    catch (QSqlError& error)
+    {
+        qDebug() << error;
+    }
+
+    return show;
+}
+
+std::unique_ptr< ShowDetails > Database::showDetails(const quintptr id) const
+{
+    TRACE_SCOPE("Database::showDetails");
 
-            show->date =  QDate::fromJulianDay(query.nextValue< qint64 >());
-            show->time = QTime::fromMSecsSinceStartOfDay(query.nextValue< int >());
+    if (const auto catalogue = verified(this->catalogue(), Catalogue::Usage::Details))
+    {
+        return catalogue->showDetails(id);
+    }
+
+    std::unique_ptr< ShowDetails > show(new ShowDetails);
+
+    if (!m_isOpen)
+    {
+        return show;
+    }
 
-            show->duration = QTime::fromMSecsSinceStartOfDay(query.nextValue< int >());
+    try
+    {
+        auto database = connection();
+        Query query(database);
 
-            show->description = query.nextValue< QString >();
-            show->website = query.nextValue< QString >();
+        query.prepare(Queries::selectShowDetails);
 
-            show->url = query.nextValue< QString >();
+        query << id;
 
-            show->urlSmallOffset = query.nextValue< unsigned short >();
-            show->urlSmallSuffix = query.nextValue< QString >();
+        query.exec();
 
-            show->urlLargeOffset = query.nextValue< unsigned short >();
-            show->urlLargeSuffix = query.nextValue< QString >();
+        if (query.nextRecord())
+        {
+            readFrom(query, *show, [this](const QVariant& description)
+            {
+                return this->description(description);
+            });
         }
     }
     catch (QSqlError& error)
@@ -520,11 +1434,29 @@ std::unique_ptr< Show > Database::show(const quintptr id) const
 
 QStringList Database::channels() const
 {
+    TRACE_SCOPE("Database::channels");
+
+    if (const auto channelIndex = this->channelIndex())
+    {
+        return channelIndex->channels();
+    }
+
+    if (const auto catalogue = verified(this->catalogue(), Catalogue::Usage::Channels))
+    {
+        return catalogue->channels();
+    }
+
+    if (!m_isOpen)
+    {
+        return {};
+    }
+
     QStringList channels;
 
     try
     {
-        Query query(m_database);
+        auto database = connection();
+        Query query(database);
 
         query.exec(QStringLiteral("SELECT DISTINCT(channel) FROM shows"));
 
@@ -543,6 +1475,23 @@ QStringList Database::channels() const
 
 QStringList Database::topics(const QString& channel) const
 {
+    TRACE_SCOPE("Database::topics");
+
+    if (const auto channelIndex = this->channelIndex())
+    {
+        return channelIndex->topics(channel);
+    }
+
+    if (const auto catalogue = verified(this->catalogue(), Catalogue::Usage::Topics))
+    {
+        return catalogue->topics(channel);
+    }
+
+    if (!m_isOpen)
+    {
+        return {};
+    }
+
     QStringList topics;
 
     const auto filterClause = channel.isEmpty() ? QStringLiteral("ifnull(1, ?)")
@@ -550,7 +1499,8 @@ QStringList Database::topics(const QString& channel) const
 
     try
     {
-        Query query(m_database);
+        auto database = connection();
+        Query query(database);
 
         query.prepare(QStringLiteral("SELECT DISTINCT(topic) FROM shows WHERE %1").arg(filterClause));
 
@@ -571,4 +1521,289 @@ QStringList Database::topics(const QString& channel) const
     return topics;
 }
 
+QMap< QString, int > Database::channelCounts() const
+{
+    if (const auto channelIndex = this->channelIndex())
+    {
+        return channelIndex->channelCounts();
+    }
+
+    return {};
+}
+
+QMap< QString, int > Database::topicCounts(const QString& channel) const
+{
+    if (const auto channelIndex = this->channelIndex())
+    {
+        return channelIndex->topicCounts(channel);
+    }
+
+    return {};
+}
+
+void Database::migrate(const int version)
+{
+    TRACE_SCOPE("Database::migrate");
+
+    auto database = connection();
+
+    Transaction transaction(database);
+
+    if (version < 1)
+    {
+        Query query(database);
+
+        if (!database.record(QStringLiteral("shows")).contains(QStringLiteral("titleKey")))
+        {
+            query.exec(QStringLiteral("ALTER TABLE shows ADD COLUMN channelKey TEXT"));
+            query.exec(QStringLiteral("ALTER TABLE shows ADD COLUMN topicKey TEXT"));
+            query.exec(QStringLiteral("ALTER TABLE shows ADD COLUMN titleKey TEXT"));
+        }
+
+        // The rows are read completely before being updated as SQLite does not define the results of a query whose table is modified meanwhile.
+        QVector< QPair< quintptr, SearchKeys > > rows;
+
+        query.exec(Queries::selectTexts);
+
+        while (query.nextRecord())
+        {
+            const auto id = query.nextValue< quintptr >();
+            const auto channel = query.nextValue< QString >();
+            const auto topic = query.nextValue< QString >();
+            const auto title = query.nextValue< QString >();
+
+            rows.append(qMakePair(id, SearchKeys{ searchKeyOf(channel), searchKeyOf(topic), searchKeyOf(title) }));
+        }
+
+        Query updateSearchKeys(database);
+        updateSearchKeys.prepare(Queries::updateSearchKeys);
+
+        for (const auto& row : rows)
+        {
+            updateSearchKeys << row.second.channel << row.second.topic << row.second.title << row.first;
+            updateSearchKeys.exec();
+        }
+    }
+
+    // Existing rows store website and URL including their prefixes which the new columns default to.
+    if (version < 2 && !database.record(QStringLiteral("shows")).contains(QStringLiteral("urlPrefix")))
+    {
+        Query query(database);
+
+        query.exec(QStringLiteral("ALTER TABLE shows ADD COLUMN websitePrefix INTEGER"));
+        query.exec(QStringLiteral("ALTER TABLE shows ADD COLUMN urlPrefix INTEGER"));
+    }
+
+    // The indices of the sort orders are recreated including the filtered columns after migrating.
+    if (version < 3)
+    {
+        Query query(database);
+
+        for (const auto index : { "showsByChannelAscending", "showsByChannelDescending", "showsByTopicAscending", "showsByTopicDescending",
+                                  "showsByTitleAscending", "showsByTitleDescending", "showsByDateAndTime", "showsByTime", "showsByDuration" })
+        {
+            query.exec(QStringLiteral("DROP INDEX IF EXISTS %1").arg(QString::fromLatin1(index)));
+        }
+    }
+
+    Query(database).exec(QStringLiteral("PRAGMA user_version = %1").arg(schemaVersion));
+
+    transaction.commit();
+}
+
+qint64 Database::storageSize() const
+{
+    TRACE_SCOPE("Database::storageSize");
+
+    if (!m_isOpen)
+    {
+        return 0;
+    }
+
+    try
+    {
+        auto database = connection();
+        Query query(database);
+
+        const auto pragma = [&query](const QString& name)
+        {
+            query.exec(QStringLiteral("PRAGMA %1").arg(name));
+
+            return query.nextRecord() ? query.nextValue< qint64 >() : 0;
+        };
+
+        const auto pageSize = pragma(QStringLiteral("page_size"));
+        const auto pageCount = pragma(QStringLiteral("page_count"));
+        const auto freePageCount = pragma(QStringLiteral("freelist_count"));
+
+        return pageSize * (pageCount - freePageCount);
+    }
+    catch (QSqlError& error)
+    {
+        qDebug() << error;
+    }
+
+    return 0;
+}
+
+QString Database::description(const QVariant& value) const
+{
+    if (value.type() != QVariant::ByteArray)
+    {
+        return value.toString();
+    }
+
+    const auto data = value.toByteArray();
+
+    return QString::fromUtf8(decompress(data, dictionary(requiredDictionaryOf(data))));
+}
+
+QByteArray Database::dictionary(const quint32 id) const
+{
+    if (id == 0)
+    {
+        return {};
+    }
+
+    QMutexLocker locker(&m_dictionariesLock);
+
+    auto iterator = m_dictionaries.find(id);
+
+    if (iterator == m_dictionaries.end())
+    {
+        auto database = connection();
+        Query query(database);
+
+        query.prepare(Queries::selectDictionary);
+
+        query << qint64(id);
+
+        query.exec();
+
+        if (!query.nextRecord())
+        {
+            return {};
+        }
+
+        // Since the identifier is a checksum of the dictionary, it can be kept even after the dictionary was removed.
+        iterator = m_dictionaries.insert(id, query.nextValue< QByteArray >());
+    }
+
+    return iterator.value();
+}
+
+void Database::openCatalogue()
+{
+    TRACE_SCOPE("Database::openCatalogue");
+
+    auto database = connection();
+    Query query(database);
+
+    query.exec(Queries::selectGeneration);
+
+    const auto generation = query.nextRecord() ? query.nextValue< quintptr >() : 0;
+
+    auto catalogue = Catalogue::open(dataFilePath(catalogueName));
+
+    if (!catalogue || catalogue->generation() != generation)
+    {
+        loadCatalogue();
+        return;
+    }
+
+    QMutexLocker locker(&m_catalogueLock);
+    m_catalogue.swap(catalogue);
+}
+
+void Database::loadCatalogue()
+{
+    TRACE_SCOPE("Database::loadCatalogue");
+
+    Catalogue::Builder builder;
+
+    auto database = connection();
+    Query query(database);
+
+    query.exec(Queries::selectShows);
+
+    Show show;
+
+    while (query.nextRecord())
+    {
+        const auto id = query.nextValue< quintptr >();
+
+        readFrom(query, show, [this](const QVariant& description)
+        {
+            return this->description(description);
+        });
+
+        builder.append(id, show);
+    }
+
+    auto catalogue = builder.build();
+
+    if (!catalogue->save(dataFilePath(catalogueName)))
+    {
+        qDebug() << "Failed to save catalogue snapshot.";
+    }
+
+    QMutexLocker locker(&m_catalogueLock);
+    m_catalogue.swap(catalogue);
+}
+
+void Database::dropCatalogue()
+{
+    // The snapshot would go stale with the next update and could then match a later generation by accident.
+    if (!QFile::remove(dataFilePath(catalogueName)) && QFile::exists(dataFilePath(catalogueName)))
+    {
+        qDebug() << "Failed to remove catalogue snapshot.";
+    }
+
+    QMutexLocker locker(&m_catalogueLock);
+    m_catalogue.reset();
+}
+
+std::shared_ptr< const Catalogue > Database::catalogue() const
+{
+    QMutexLocker locker(&m_catalogueLock);
+    return m_catalogue;
+}
+
+void Database::loadChannelIndex()
+{
+    TRACE_SCOPE("Database::loadChannelIndex");
+
+    ChannelIndex channelIndex;
+
+    auto database = connection();
+    Query query(database);
+
+    query.exec(Queries::selectChannelIndex);
+
+    while (query.nextRecord())
+    {
+        const auto channel = query.nextValue< QString >();
+        const auto topic = query.nextValue< QString >();
+        const auto count = query.nextValue< int >();
+
+        channelIndex.insert(channel, topic, count);
+    }
+
+    setChannelIndex(channelIndex);
+}
+
+void Database::setChannelIndex(const ChannelIndex& channelIndex)
+{
+    std::shared_ptr< const ChannelIndex > pointer(new ChannelIndex(channelIndex));
+
+    QMutexLocker locker(&m_channelIndexLock);
+    m_channelIndex.swap(pointer);
+}
+
+std::shared_ptr< const ChannelIndex > Database::channelIndex() const
+{
+    QMutexLocker locker(&m_channelIndexLock);
+    return m_channelIndex;
+}
+
 } // QMediathekView
@@ -22,18 +22,61 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <atomic>
 #include <memory>
 
+#include <QCache>
 #include <QFuture>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QSqlDatabase>
+#include <QVariant>
+#include <QStringList>
+#include <QThreadPool>
 
 #include "schema.h"
 
 namespace QMediathekView
 {
 
+// Identifies a show independently of its row in the database.
+QByteArray keyOf(const Show& show);
+
+// Restricts the shows yielded by a query where empty or invalid members impose no restriction.
+struct Filter
+{
+    // Contained ignoring case and diacritics.
+    QString channel;
+    QString topic;
+    QString title;
+
+    // Matched exactly.
+    QStringList channels;
+
+    // All ranges are inclusive. Shows without a date are excluded by any date range
+    // and a time range wraps around midnight if it ends before it begins.
+    QDate fromDate;
+    QDate toDate;
+
+    QTime fromTime;
+    QTime toTime;
+
+    QTime minimumDuration;
+    QTime maximumDuration;
+
+    bool operator==(const Filter& other) const;
+    bool operator!=(const Filter& other) const;
+
+    QString key() const;
+
+};
+
 class Settings;
+class Timings;
+class Catalogue;
+class ChannelIndex;
 
 class Database : public QObject
 {
@@ -41,13 +84,23 @@ class Database : public QObject
     Q_DISABLE_COPY(Database)
 
 public:
-    Database(Settings& settings, QObject* parent = 0);
+    Database(Settings& settings, Timings& timings, QObject* parent = 0);
     ~Database();
 
 signals:
+    void opened();
+
     void updated();
     void failedToUpdate(const QString& error);
 
+public:
+    // Opens the database and warms up the catalogue in a worker thread, emitting opened when done.
+    void open();
+    void waitForOpened() const;
+
+    // Queries yield no results until the database has been opened.
+    bool isOpen() const;
+
 public:
     void fullUpdate(const QByteArray& data);
     void partialUpdate(const QByteArray& data);
@@ -67,23 +120,82 @@ public:
         SortDuration
     };
 
-    QVector< quintptr > query(
-        const QString& channel, const QString& topic, const QString& title,
-        const SortColumn sortColumn, const Qt::SortOrder sortOrder) const;
+    // Results are cached until the next update within the configured budget.
+    QVector< quintptr > query(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder) const;
+
+    // Yields the steps SQLite plans for the query, independently of the in-memory catalogue.
+    QStringList explainQuery(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder) const;
+
+private:
+    QVector< quintptr > fetchQuery(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder) const;
+
+    static QString queryStatement(const Filter& filter, const SortColumn sortColumn, const Qt::SortOrder sortOrder, QVariantList& values);
 
 public:
+    // Decompresses the description of the show if it was stored using compressed storage.
     std::unique_ptr< Show > show(const quintptr id) const;
 
+    // The list of shows only needs the row of each show whereas the details are fetched for the selected show.
+    std::unique_ptr< ShowRow > showRow(const quintptr id) const;
+    std::unique_ptr< ShowDetails > showDetails(const quintptr id) const;
+
     QStringList channels() const;
     QStringList topics(const QString& channel) const;
 
+    // Yields the number of shows per channel or topic if they are already known, i.e. without querying.
+    QMap< QString, int > channelCounts() const;
+    QMap< QString, int > topicCounts(const QString& channel) const;
+
+    // In bytes, i.e. the pages in use by the database file.
+    qint64 storageSize() const;
+
 private:
     Settings& m_settings;
+    Timings& m_timings;
+
+    // Qt does not support using a connection from any thread but the one which created it,
+    // so each thread uses its own connection which is opened on first use.
+    const QString m_connectionName;
+
+    mutable QMutex m_connectionsLock;
+    mutable QStringList m_connections;
+
+    QSqlDatabase connection() const;
+
+    QThreadPool m_worker;
 
-    mutable QSqlDatabase m_database;
+    QFuture< void > m_open;
+    std::atomic< bool > m_isOpen;
 
     QFuture< void > m_update;
 
+    mutable QMutex m_queryCacheLock;
+    mutable QCache< QString, QVector< quintptr > > m_queryCache;
+    quint64 m_generation;
+
+    mutable QMutex m_catalogueLock;
+    std::shared_ptr< const Catalogue > m_catalogue;
+
+    void migrate(const int version);
+
+    mutable QMutex m_dictionariesLock;
+    mutable QHash< quint32, QByteArray > m_dictionaries;
+
+    QString description(const QVariant& value) const;
+    QByteArray dictionary(const quint32 id) const;
+
+    void openCatalogue();
+    void loadCatalogue();
+    void dropCatalogue();
+    std::shared_ptr< const Catalogue > catalogue() const;
+
+    mutable QMutex m_channelIndexLock;
+    std::shared_ptr< const ChannelIndex > m_channelIndex;
+
+    void loadChannelIndex();
+    void setChannelIndex(const ChannelIndex& channelIndex);
+    std::shared_ptr< const ChannelIndex > channelIndex() const;
+
 };
 
 } // QMediathekView
@@ -0,0 +1,63 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "decompressor.h"
+
+#include "trace.h"
+
+namespace QMediathekView
+{
+
+Decompressor::Decompressor()
+    : m_stream(LZMA_STREAM_INIT)
+{
+    Q_UNUSED(lzma_stream_decoder(&m_stream, UINT64_MAX, LZMA_TELL_NO_CHECK));
+}
+
+Decompressor::~Decompressor()
+{
+    lzma_end(&m_stream);
+}
+
+void Decompressor::appendData(const QByteArray& data)
+{
+    TRACE_SCOPE("Decompressor::appendData");
+
+    m_stream.next_in = reinterpret_cast< const std::uint8_t* >(data.constData());
+    m_stream.avail_in = data.size();
+
+    for (lzma_ret result = LZMA_OK; result == LZMA_OK;)
+    {
+        m_stream.next_out = m_buffer;
+        m_stream.avail_out = sizeof(m_buffer);
+
+        result = lzma_code(&m_stream, LZMA_RUN);
+
+        m_data.append(reinterpret_cast< const char* >(m_buffer), sizeof(m_buffer) - m_stream.avail_out);
+    }
+}
+
+const QByteArray& Decompressor::data() const
+{
+    return m_data;
+}
+
+} // QMediathekView
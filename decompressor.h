@@ -0,0 +1,55 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DECOMPRESSOR_H
+#define DECOMPRESSOR_H
+
+#include <cstdint>
+
+#include <QByteArray>
+
+#include <lzma.h>
+
+namespace QMediathekView
+{
+
+class Decompressor
+{
+public:
+    Decompressor();
+    ~Decompressor();
+
+    void appendData(const QByteArray& data);
+
+    const QByteArray& data() const;
+
+private:
+    Q_DISABLE_COPY(Decompressor)
+
+    lzma_stream m_stream;
+    std::uint8_t m_buffer[64 * 1024];
+    QByteArray m_data;
+
+};
+
+} // QMediathekView
+
+#endif // DECOMPRESSOR_H
@@ -0,0 +1,1104 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "download.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif // Q_OS_LINUX
+
+#include "tokenbucket.h"
+#include "trace.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr qint64 minimumSegmentSize = 1024 * 1024;
+
+constexpr auto maximumRetries = 3;
+constexpr auto retryDelay = 1000;
+
+constexpr auto saveStateInterval = 5 * 1000;
+
+// Received data is collected and written in blocks of at least this size ending at an aligned offset.
+constexpr qint64 coalescedSize = 1024 * 1024;
+constexpr qint64 blockAlignment = 64 * 1024;
+
+constexpr auto progressInterval = 100;
+
+// Bounds the data buffered per connection while reading is throttled so that the sender is slowed down as well.
+constexpr qint64 readBufferSize = 1024 * 1024;
+
+namespace Keys
+{
+
+const auto url = QStringLiteral("url");
+const auto entityTag = QStringLiteral("entityTag");
+const auto lastModified = QStringLiteral("lastModified");
+const auto size = QStringLiteral("size");
+const auto ranges = QStringLiteral("ranges");
+
+} // Keys
+
+QString partialFilePath(const QString& filePath)
+{
+    return filePath + QStringLiteral(".part");
+}
+
+QString stateFilePath(const QString& filePath)
+{
+    return filePath + QStringLiteral(".part.json");
+}
+
+// Parses a header of the form "bytes 100-199/1000" where the total may be given as "*".
+bool parseContentRange(const QByteArray& header, qint64& begin, qint64& total)
+{
+    const auto prefix = QByteArrayLiteral("bytes ");
+
+    if (!header.startsWith(prefix))
+    {
+        return false;
+    }
+
+    const auto dash = header.indexOf('-', prefix.size());
+    const auto slash = header.indexOf('/', dash);
+
+    if (dash < 0 || slash < 0)
+    {
+        return false;
+    }
+
+    bool ok = false;
+
+    begin = header.mid(prefix.size(), dash - prefix.size()).toLongLong(&ok);
+
+    if (!ok)
+    {
+        return false;
+    }
+
+    const auto length = header.mid(slash + 1);
+
+    if (length == "*")
+    {
+        total = -1;
+        return true;
+    }
+
+    total = length.toLongLong(&ok);
+
+    return ok;
+}
+
+void stop(QObject* receiver, QNetworkReply* reply)
+{
+    QObject::disconnect(reply, nullptr, receiver, nullptr);
+
+    reply->abort();
+    reply->deleteLater();
+}
+
+} // anonymous
+
+bool Download::Segment::isOpenEnded() const
+{
+    return end < 0;
+}
+
+bool Download::Segment::isPending() const
+{
+    return reply == nullptr && !retrying && !isOpenEnded() && remaining() > 0;
+}
+
+qint64 Download::Segment::remaining() const
+{
+    return end - position;
+}
+
+qint64 Download::Segment::written() const
+{
+    return position - buffered;
+}
+
+qint64 Download::Segment::remainingTime() const
+{
+    const auto received = position - startedAt;
+    const auto elapsed = timer.elapsed();
+
+    if (received <= 0 || elapsed <= 0)
+    {
+        return std::numeric_limits< qint64 >::max();
+    }
+
+    return remaining() * elapsed / received;
+}
+
+Download::Download(
+    QNetworkAccessManager* networkManager,
+    const QString& userAgent,
+    const QUrl& url,
+    const QString& filePath,
+    const int segments,
+    TokenBucket* tokenBucket,
+    QObject* parent)
+    : Transfer(parent)
+    , m_networkManager(networkManager)
+    , m_userAgent(userAgent)
+    , m_url(url)
+    , m_filePath(filePath)
+    , m_segmentCount(qMax(1, segments))
+    , m_tokenBucket(tokenBucket)
+    , m_file(new QFile(partialFilePath(filePath)))
+    , m_saveTimer(new QTimer(this))
+    , m_rangesSupported(false)
+    , m_resuming(false)
+    , m_generation(0)
+    , m_bytesReceived(0)
+    , m_bytesTotal(-1)
+    , m_hash(QCryptographicHash::Sha256)
+    , m_hashed(0)
+    , m_finished(false)
+{
+    m_saveTimer->setInterval(saveStateInterval);
+
+    connect(m_saveTimer, &QTimer::timeout, this, [this]()
+    {
+        saveState();
+    });
+
+    if (m_tokenBucket != nullptr)
+    {
+        connect(m_tokenBucket, &TokenBucket::refilled, this, &Download::drain);
+    }
+}
+
+Download::~Download()
+{
+    if (!m_finished)
+    {
+        stopSegments();
+
+        if (!saveState())
+        {
+            m_file->remove();
+        }
+    }
+}
+
+void Download::start()
+{
+    // Opening for reading as well keeps the partial data of an earlier attempt.
+    if (!m_file->open(QIODevice::ReadWrite))
+    {
+        m_finished = true;
+        m_errorString = m_file->errorString();
+
+        emit finished(false);
+        return;
+    }
+
+    m_saveTimer->start();
+
+    if (loadState())
+    {
+        reportProgress(true);
+
+        if (!startPending())
+        {
+            QTimer::singleShot(0, this, &Download::complete);
+        }
+    }
+    else
+    {
+        restart();
+    }
+}
+
+void Download::abort()
+{
+    fail(tr("Download was canceled."));
+}
+
+void Download::discard(const QString& filePath)
+{
+    QFile::remove(partialFilePath(filePath));
+    QFile::remove(stateFilePath(filePath));
+}
+
+QString Download::errorString() const
+{
+    return m_errorString;
+}
+
+bool Download::loadState()
+{
+    QFile file(stateFilePath(m_filePath));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    const auto state = QJsonDocument::fromJson(file.readAll()).object();
+
+    m_entityTag = state.value(Keys::entityTag).toString().toUtf8();
+    m_lastModified = state.value(Keys::lastModified).toString().toUtf8();
+
+    const auto size = qint64(state.value(Keys::size).toDouble(-1));
+
+    if (state.value(Keys::url).toString() != m_url.toString() || validator().isEmpty() || size < 0 || m_file->size() != size)
+    {
+        return false;
+    }
+
+    QVector< QPair< qint64, qint64 > > ranges;
+
+    for (const auto& value : state.value(Keys::ranges).toArray())
+    {
+        const auto range = value.toArray();
+        const auto begin = qint64(range.at(0).toDouble(-1));
+        const auto end = qint64(range.at(1).toDouble(-1));
+
+        if (begin < 0 || end < begin || end > size)
+        {
+            return false;
+        }
+
+        ranges.append(qMakePair(begin, end));
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+
+    // Completed ranges are kept as finished segments and the gaps between them become pending segments.
+    qint64 position = 0;
+
+    for (const auto& range : ranges)
+    {
+        if (range.first > position)
+        {
+            addSegment(position, range.first);
+        }
+
+        if (range.second > position)
+        {
+            auto& segment = addSegment(qMax(position, range.first), range.second);
+            segment.position = segment.end;
+
+            m_bytesReceived += segment.end - segment.begin;
+            position = range.second;
+        }
+    }
+
+    if (size > position)
+    {
+        addSegment(position, size);
+    }
+
+    m_bytesTotal = size;
+    m_rangesSupported = true;
+    m_resuming = true;
+
+    return true;
+}
+
+bool Download::saveState()
+{
+    QFile::remove(stateFilePath(m_filePath));
+
+    if (!m_rangesSupported || m_bytesTotal < 0 || validator().isEmpty())
+    {
+        return false;
+    }
+
+    // The data must reach the disk before the state claims it has been received.
+    writeAll();
+
+    if (!m_file->flush())
+    {
+        return false;
+    }
+
+    QJsonArray ranges;
+
+    for (const auto& segment : m_segments)
+    {
+        if (segment->written() > segment->begin)
+        {
+            ranges.append(QJsonArray() << double(segment->begin) << double(segment->written()));
+        }
+    }
+
+    QJsonObject state;
+
+    state.insert(Keys::url, m_url.toString());
+    state.insert(Keys::entityTag, QString::fromUtf8(m_entityTag));
+    state.insert(Keys::lastModified, QString::fromUtf8(m_lastModified));
+    state.insert(Keys::size, double(m_bytesTotal));
+    state.insert(Keys::ranges, ranges);
+
+    QSaveFile file(stateFilePath(m_filePath));
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    file.write(QJsonDocument(state).toJson(QJsonDocument::Compact));
+
+    return file.commit();
+}
+
+QByteArray Download::validator() const
+{
+    // Weak entity tags must not be used with If-Range.
+    if (!m_entityTag.isEmpty() && !m_entityTag.startsWith("W/"))
+    {
+        return m_entityTag;
+    }
+
+    return m_lastModified;
+}
+
+bool Download::checkValidators(const QNetworkReply* reply)
+{
+    const auto entityTag = reply->rawHeader("ETag");
+    const auto lastModified = reply->rawHeader("Last-Modified");
+
+    if (!m_resuming)
+    {
+        if (m_entityTag.isEmpty() && m_lastModified.isEmpty())
+        {
+            m_entityTag = entityTag;
+            m_lastModified = lastModified;
+        }
+
+        return true;
+    }
+
+    if (!m_entityTag.isEmpty() && !entityTag.isEmpty())
+    {
+        return m_entityTag == entityTag;
+    }
+
+    if (!m_lastModified.isEmpty() && !lastModified.isEmpty())
+    {
+        return m_lastModified == lastModified;
+    }
+
+    return true;
+}
+
+void Download::restart()
+{
+    if (m_finished)
+    {
+        return;
+    }
+
+    ++m_generation;
+
+    stopSegments();
+    m_segments.clear();
+
+    m_entityTag.clear();
+    m_lastModified.clear();
+
+    m_rangesSupported = false;
+    m_resuming = false;
+
+    m_bytesReceived = 0;
+    m_bytesTotal = -1;
+
+    m_hash.reset();
+    m_hashed = 0;
+
+    QFile::remove(stateFilePath(m_filePath));
+
+    if (!m_file->resize(0))
+    {
+        fail(m_file->errorString());
+        return;
+    }
+
+    reportProgress(true);
+
+    startSegment(addSegment(0, -1));
+}
+
+void Download::stopSegments()
+{
+    for (const auto& segment : m_segments)
+    {
+        if (segment->reply != nullptr)
+        {
+            stop(this, segment->reply);
+            segment->reply = nullptr;
+        }
+
+        segment->retrying = false;
+    }
+}
+
+bool Download::startPending()
+{
+    auto active = std::count_if(m_segments.begin(), m_segments.end(), [](const std::unique_ptr< Segment >& segment)
+    {
+        return segment->reply != nullptr || segment->retrying;
+    });
+
+    auto started = false;
+
+    for (const auto& segment : m_segments)
+    {
+        if (active >= m_segmentCount)
+        {
+            break;
+        }
+
+        if (segment->isPending())
+        {
+            startSegment(*segment);
+
+            ++active;
+            started = true;
+        }
+    }
+
+    return started;
+}
+
+void Download::drain()
+{
+    // Segments may be added while reading, hence the loop by index.
+    for (std::size_t index = 0; index < m_segments.size() && !m_finished; ++index)
+    {
+        auto& segment = *m_segments[index];
+
+        if (segment.reply != nullptr && segment.reply->bytesAvailable() > 0)
+        {
+            readSegment(segment);
+        }
+
+        if (segment.reply != nullptr && segment.reply->isFinished() && segment.reply->bytesAvailable() == 0)
+        {
+            finishSegment(segment);
+        }
+    }
+}
+
+void Download::startSegment(Segment& segment)
+{
+    QNetworkRequest request(m_url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, m_userAgent);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+
+    // Asking for an open-ended range up front tells us whether the server supports ranges without an additional round trip.
+    auto range = QByteArrayLiteral("bytes=") + QByteArray::number(segment.position) + '-';
+
+    if (!segment.isOpenEnded())
+    {
+        range += QByteArray::number(segment.end - 1);
+    }
+
+    request.setRawHeader("Range", range);
+
+    // The server sends the whole entity instead of the range if it has changed since the partial data was received.
+    if (m_resuming)
+    {
+        request.setRawHeader("If-Range", validator());
+    }
+
+    segment.checked = false;
+    segment.retrying = false;
+    segment.timer.start();
+    segment.startedAt = segment.position;
+
+    const auto reply = m_networkManager->get(request);
+    const auto segmentPointer = &segment;
+
+    segment.reply = reply;
+
+    reply->setReadBufferSize(readBufferSize);
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, segmentPointer]()
+    {
+        readSegment(*segmentPointer);
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [this, segmentPointer]()
+    {
+        finishSegment(*segmentPointer);
+    });
+}
+
+bool Download::checkSegment(Segment& segment)
+{
+    QNetworkReply* const reply = segment.reply;
+    const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (status == 206)
+    {
+        qint64 begin = 0;
+        qint64 total = -1;
+
+        if (!parseContentRange(reply->rawHeader("Content-Range"), begin, total) || begin != segment.position)
+        {
+            fail(tr("Received an unexpected range."));
+            return false;
+        }
+
+        if (!checkValidators(reply) || (m_bytesTotal >= 0 && total >= 0 && total != m_bytesTotal))
+        {
+            // The entity has changed, so the partial data must not be combined with the new one.
+            stopSegments();
+            QTimer::singleShot(0, this, &Download::restart);
+            return false;
+        }
+
+        m_rangesSupported = true;
+
+        if (m_bytesTotal < 0 && total >= 0)
+        {
+            m_bytesTotal = total;
+
+            if (!allocate(total))
+            {
+                fail(m_file->errorString());
+                return false;
+            }
+
+            if (segment.isOpenEnded())
+            {
+                const auto segmentSize = qMax(minimumSegmentSize, total / m_segmentCount);
+
+                segment.end = qMin(total, segmentSize);
+
+                for (auto offset = segment.end; offset < total;)
+                {
+                    auto end = qMin(total, offset + segmentSize);
+
+                    if (total - end < minimumSegmentSize)
+                    {
+                        end = total;
+                    }
+
+                    startSegment(addSegment(offset, end));
+
+                    offset = end;
+                }
+            }
+        }
+    }
+    else if (!m_resuming && segment.position == 0 && m_segments.size() == 1)
+    {
+        // The server ignored the range, so we fall back to a single stream.
+        const auto contentLength = reply->header(QNetworkRequest::ContentLengthHeader);
+
+        m_bytesTotal = contentLength.isValid() ? contentLength.toLongLong() : -1;
+    }
+    else
+    {
+        // Either the entity has changed since the partial data was received or ranges are not supported after all.
+        stopSegments();
+        QTimer::singleShot(0, this, &Download::restart);
+        return false;
+    }
+
+    segment.checked = true;
+
+    return true;
+}
+
+void Download::readSegment(Segment& segment)
+{
+    TRACE_SCOPE("Download::readSegment");
+
+    QNetworkReply* const reply = segment.reply;
+
+    if (reply == nullptr || reply->error() != QNetworkReply::NoError)
+    {
+        return;
+    }
+
+    if (!segment.checked && !checkSegment(segment))
+    {
+        return;
+    }
+
+    auto available = reply->bytesAvailable();
+
+    if (m_tokenBucket != nullptr)
+    {
+        available = m_tokenBucket->take(available);
+    }
+
+    auto data = reply->read(available);
+
+    // The reply might extend beyond the segment if it was split after the request was made.
+    if (!segment.isOpenEnded() && data.size() > segment.remaining())
+    {
+        data.truncate(segment.remaining());
+    }
+
+    if (!data.isEmpty())
+    {
+        // The chunk is kept as is and only copied once enough data has been collected for a block.
+        segment.chunks.append(data);
+        segment.buffered += data.size();
+
+        segment.position += data.size();
+        m_bytesReceived += data.size();
+
+        if (!write(segment, false))
+        {
+            fail(m_file->errorString());
+            return;
+        }
+
+        reportProgress(false);
+    }
+
+    if (!segment.isOpenEnded() && segment.remaining() == 0)
+    {
+        completeSegment(segment);
+    }
+}
+
+bool Download::write(Segment& segment, const bool all)
+{
+    TRACE_SCOPE("Download::write");
+
+    const auto begin = segment.written();
+    auto end = segment.position;
+
+    if (!all)
+    {
+        if (segment.buffered < coalescedSize)
+        {
+            return true;
+        }
+
+        // The tail after the last block boundary stays buffered so that writes start and end aligned.
+        const auto aligned = end - end % blockAlignment;
+
+        if (aligned > begin)
+        {
+            end = aligned;
+        }
+    }
+
+    const auto size = end - begin;
+
+    if (size == 0)
+    {
+        return true;
+    }
+
+    const char* data = nullptr;
+    const auto coalesced = segment.chunkOffset + size > segment.chunks.first().size();
+
+    if (!coalesced)
+    {
+        data = segment.chunks.first().constData() + segment.chunkOffset;
+    }
+    else
+    {
+        m_block.resize(size);
+
+        for (qint64 copied = 0; copied < size;)
+        {
+            const auto& chunk = segment.chunks.first();
+            const auto count = qMin(size - copied, qint64(chunk.size() - segment.chunkOffset));
+
+            std::copy_n(chunk.constData() + segment.chunkOffset, count, m_block.data() + copied);
+
+            copied += count;
+            segment.chunkOffset += count;
+
+            if (segment.chunkOffset == chunk.size())
+            {
+                segment.chunks.removeFirst();
+                segment.chunkOffset = 0;
+            }
+        }
+
+        data = m_block.constData();
+    }
+
+    if (!m_file->seek(begin) || m_file->write(data, size) != size)
+    {
+        return false;
+    }
+
+    if (computeChecksum() && begin == m_hashed)
+    {
+        m_hash.addData(data, size);
+        m_hashed = end;
+    }
+
+    if (!coalesced)
+    {
+        segment.chunkOffset += size;
+
+        if (segment.chunkOffset == segment.chunks.first().size())
+        {
+            segment.chunks.removeFirst();
+            segment.chunkOffset = 0;
+        }
+    }
+
+    segment.buffered -= size;
+
+    return true;
+}
+
+bool Download::writeAll()
+{
+    auto ok = true;
+
+    for (const auto& segment : m_segments)
+    {
+        ok = write(*segment, true) && ok;
+    }
+
+    return ok;
+}
+
+bool Download::allocate(const qint64 size)
+{
+#ifdef Q_OS_LINUX
+
+    // Reserves the blocks up front to avoid fragmentation, but only where this does not fall back to writing zeros.
+    if (::fallocate(m_file->handle(), 0, 0, size) == 0)
+    {
+        return true;
+    }
+
+#endif // Q_OS_LINUX
+
+    return m_file->resize(size);
+}
+
+bool Download::hashRemaining()
+{
+    const auto size = m_file->size();
+
+    if (!m_file->seek(m_hashed))
+    {
+        return false;
+    }
+
+    while (m_hashed < size)
+    {
+        m_block.resize(qMin(coalescedSize, size - m_hashed));
+
+        if (m_file->read(m_block.data(), m_block.size()) != m_block.size())
+        {
+            return false;
+        }
+
+        m_hash.addData(m_block);
+        m_hashed += m_block.size();
+    }
+
+    return true;
+}
+
+void Download::reportProgress(const bool force)
+{
+    if (!force && m_progressTimer.isValid() && m_progressTimer.elapsed() < progressInterval)
+    {
+        return;
+    }
+
+    m_progressTimer.start();
+
+    emit progress(m_bytesReceived, m_bytesTotal);
+}
+
+void Download::finishSegment(Segment& segment)
+{
+    QNetworkReply* const reply = segment.reply;
+
+    if (reply == nullptr)
+    {
+        return;
+    }
+
+    auto error = reply->errorString();
+
+    if (reply->error() == QNetworkReply::NoError)
+    {
+        readSegment(segment);
+
+        // Throttled data is drained once the token bucket has been refilled.
+        if (m_finished || segment.reply == nullptr || segment.reply->bytesAvailable() > 0)
+        {
+            return;
+        }
+
+        if (segment.isOpenEnded() && (m_bytesTotal < 0 || segment.position == m_bytesTotal))
+        {
+            completeSegment(segment);
+            return;
+        }
+
+        error = tr("Connection was closed prematurely.");
+    }
+
+    segment.reply = nullptr;
+    reply->deleteLater();
+
+    if (m_rangesSupported && segment.retries < maximumRetries)
+    {
+        const auto segmentPointer = &segment;
+        const auto generation = m_generation;
+
+        segment.retrying = true;
+
+        QTimer::singleShot(retryDelay << segment.retries++, this, [this, segmentPointer, generation]()
+        {
+            if (!m_finished && m_generation == generation && segmentPointer->retrying)
+            {
+                startSegment(*segmentPointer);
+            }
+        });
+
+        return;
+    }
+
+    fail(error);
+}
+
+void Download::completeSegment(Segment& segment)
+{
+    if (segment.reply != nullptr)
+    {
+        stop(this, segment.reply);
+        segment.reply = nullptr;
+    }
+
+    if (!write(segment, true))
+    {
+        fail(m_file->errorString());
+        return;
+    }
+
+    if (segment.isOpenEnded())
+    {
+        segment.end = segment.position;
+    }
+
+    const auto done = std::all_of(m_segments.begin(), m_segments.end(), [](const std::unique_ptr< Segment >& segment)
+    {
+        return segment->reply == nullptr && !segment->retrying && segment->remaining() == 0;
+    });
+
+    if (done)
+    {
+        complete();
+        return;
+    }
+
+    saveState();
+
+    if (!startPending())
+    {
+        splitSlowest();
+    }
+}
+
+void Download::split(Segment& segment)
+{
+    const auto middle = segment.position + segment.remaining() / 2;
+
+    auto& other = addSegment(middle, segment.end);
+    segment.end = middle;
+
+    startSegment(other);
+}
+
+void Download::splitSlowest()
+{
+    if (!m_rangesSupported)
+    {
+        return;
+    }
+
+    const auto active = std::count_if(m_segments.begin(), m_segments.end(), [](const std::unique_ptr< Segment >& segment)
+    {
+        return segment->reply != nullptr || segment->retrying;
+    });
+
+    if (active >= m_segmentCount)
+    {
+        return;
+    }
+
+    Segment* slowest = nullptr;
+
+    for (const auto& segment : m_segments)
+    {
+        if (segment->reply == nullptr || !segment->checked || segment->isOpenEnded())
+        {
+            continue;
+        }
+
+        if (slowest == nullptr || slowest->remainingTime() < segment->remainingTime())
+        {
+            slowest = segment.get();
+        }
+    }
+
+    if (slowest != nullptr && slowest->remaining() >= 2 * minimumSegmentSize)
+    {
+        split(*slowest);
+    }
+}
+
+void Download::fail(const QString& error)
+{
+    if (m_finished)
+    {
+        return;
+    }
+
+    m_finished = true;
+    m_errorString = error;
+
+    m_saveTimer->stop();
+
+    stopSegments();
+
+    // Partial data is kept so that the next attempt can continue where this one stopped.
+    if (!saveState())
+    {
+        m_file->close();
+        m_file->remove();
+    }
+    else
+    {
+        m_file->close();
+    }
+
+    emit finished(false);
+}
+
+void Download::complete()
+{
+    if (m_finished)
+    {
+        return;
+    }
+
+    m_finished = true;
+
+    m_saveTimer->stop();
+
+    reportProgress(true);
+
+    if (!writeAll() || !m_file->flush())
+    {
+        m_errorString = m_file->errorString();
+
+        m_file->close();
+        m_file->remove();
+        QFile::remove(stateFilePath(m_filePath));
+
+        emit finished(false);
+        return;
+    }
+
+    // A connection closed early by the server looks like a completed stream otherwise.
+    if (m_bytesTotal >= 0 && m_bytesReceived != m_bytesTotal)
+    {
+        m_errorString = tr("The download is incomplete.");
+
+        m_file->close();
+        m_file->remove();
+        QFile::remove(stateFilePath(m_filePath));
+
+        emit finished(false);
+        return;
+    }
+
+    if (computeChecksum())
+    {
+        if (!hashRemaining())
+        {
+            m_errorString = m_file->errorString();
+
+            m_file->close();
+
+            emit finished(false);
+            return;
+        }
+
+        setChecksum(m_hash.result());
+    }
+
+    m_file->close();
+
+    QFile::remove(m_filePath);
+
+    if (!m_file->rename(m_filePath))
+    {
+        m_errorString = m_file->errorString();
+
+        emit finished(false);
+        return;
+    }
+
+    QFile::remove(stateFilePath(m_filePath));
+
+    emit finished(true);
+}
+
+Download::Segment& Download::addSegment(const qint64 begin, const qint64 end)
+{
+    std::unique_ptr< Segment > segment(new Segment);
+
+    segment->begin = begin;
+    segment->end = end;
+    segment->position = begin;
+
+    m_segments.push_back(std::move(segment));
+
+    return *m_segments.back();
+}
+
+} // QMediathekView
@@ -0,0 +1,172 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DOWNLOAD_H
+#define DOWNLOAD_H
+
+#include <memory>
+#include <vector>
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+#include "transfer.h"
+
+class QFile;
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+namespace QMediathekView
+{
+
+class TokenBucket;
+
+// Expected to live in a dedicated I/O thread together with its network access manager and token bucket.
+class Download : public Transfer
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Download)
+
+public:
+    Download(
+        QNetworkAccessManager* networkManager,
+        const QString& userAgent,
+        const QUrl& url,
+        const QString& filePath,
+        const int segments,
+        TokenBucket* tokenBucket,
+        QObject* parent = 0);
+    ~Download();
+
+public:
+    void start() override;
+    void abort() override;
+
+    // Removes the partial data and state left behind by an interrupted download.
+    static void discard(const QString& filePath);
+
+    QString errorString() const override;
+
+private:
+    struct Segment
+    {
+        qint64 begin;
+        qint64 end;
+        qint64 position;
+
+        // Guarded as the replies are owned by the network access manager which might go away first.
+        QPointer< QNetworkReply > reply;
+        bool checked = false;
+        bool retrying = false;
+        int retries = 0;
+
+        QElapsedTimer timer;
+        qint64 startedAt = 0;
+
+        // Received data not yet written, ending at the current position.
+        QVector< QByteArray > chunks;
+        int chunkOffset = 0;
+        qint64 buffered = 0;
+
+        qint64 written() const;
+
+        bool isOpenEnded() const;
+        bool isPending() const;
+        qint64 remaining() const;
+        qint64 remainingTime() const;
+    };
+
+    bool loadState();
+    bool saveState();
+    QByteArray validator() const;
+    bool checkValidators(const QNetworkReply* reply);
+
+    void restart();
+    void stopSegments();
+    bool startPending();
+
+    void drain();
+
+    bool write(Segment& segment, const bool all);
+    bool writeAll();
+
+    bool allocate(const qint64 size);
+    bool hashRemaining();
+    void reportProgress(const bool force);
+
+    void startSegment(Segment& segment);
+    bool checkSegment(Segment& segment);
+    void readSegment(Segment& segment);
+    void finishSegment(Segment& segment);
+    void completeSegment(Segment& segment);
+
+    void split(Segment& segment);
+    void splitSlowest();
+
+    void fail(const QString& error);
+    void complete();
+
+    Segment& addSegment(const qint64 begin, const qint64 end);
+
+private:
+    QNetworkAccessManager* m_networkManager;
+
+    const QString m_userAgent;
+    const QUrl m_url;
+    const QString m_filePath;
+    const int m_segmentCount;
+
+    TokenBucket* m_tokenBucket;
+
+    std::unique_ptr< QFile > m_file;
+    QTimer* m_saveTimer;
+
+    QByteArray m_entityTag;
+    QByteArray m_lastModified;
+
+    std::vector< std::unique_ptr< Segment > > m_segments;
+    bool m_rangesSupported;
+    bool m_resuming;
+    int m_generation;
+
+    QByteArray m_block;
+
+    qint64 m_bytesReceived;
+    qint64 m_bytesTotal;
+
+    // Data is hashed as it is written in order, the rest is read back once complete.
+    QCryptographicHash m_hash;
+    qint64 m_hashed;
+
+    QElapsedTimer m_progressTimer;
+
+    bool m_finished;
+    QString m_errorString;
+
+};
+
+} // QMediathekView
+
+#endif // DOWNLOAD_H
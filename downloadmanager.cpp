@@ -0,0 +1,843 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "downloadmanager.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+
+#include "settings.h"
+#include "download.h"
+#include "hlsdownload.h"
+#include "tokenbucket.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+const auto queueName = QStringLiteral("downloads.json");
+const auto completedName = QStringLiteral("completed.json");
+
+constexpr auto refreshInterval = 250;
+
+// Weight of the latest sample in the moving average of the throughput.
+constexpr auto throughputSmoothing = 0.3;
+
+namespace Keys
+{
+
+const auto title = QStringLiteral("title");
+const auto url = QStringLiteral("url");
+const auto filePath = QStringLiteral("filePath");
+const auto key = QStringLiteral("key");
+const auto priority = QStringLiteral("priority");
+const auto state = QStringLiteral("state");
+const auto bytesReceived = QStringLiteral("bytesReceived");
+const auto bytesTotal = QStringLiteral("bytesTotal");
+const auto error = QStringLiteral("error");
+const auto size = QStringLiteral("size");
+const auto checksum = QStringLiteral("checksum");
+
+} // Keys
+
+QString dataFilePath(const QString& name)
+{
+    const auto path = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    QDir().mkpath(path);
+
+    return QDir(path).filePath(name);
+}
+
+QString formatSize(const qint64 bytes)
+{
+    return DownloadManager::tr("%1 MB").arg(bytes / 1024.0 / 1024.0, 0, 'f', 1);
+}
+
+QString formatRate(const double bytesPerSecond)
+{
+    return DownloadManager::tr("%1 MB/s").arg(bytesPerSecond / 1024.0 / 1024.0, 0, 'f', 1);
+}
+
+QString formatDuration(const qint64 seconds)
+{
+    return QStringLiteral("%1:%2:%3")
+            .arg(seconds / 3600)
+            .arg(seconds / 60 % 60, 2, 10, QLatin1Char('0'))
+            .arg(seconds % 60, 2, 10, QLatin1Char('0'));
+}
+
+} // anonymous
+
+DownloadManager::DownloadManager(const Settings& settings, QObject* parent)
+    : QAbstractTableModel(parent)
+    , m_settings(settings)
+    , m_thread(new QThread(this))
+    , m_networkManager(new QNetworkAccessManager)
+    , m_tokenBucket(new TokenBucket)
+    , m_bandwidthLimit(-1)
+    , m_nextId(0)
+    , m_refreshTimer(new QTimer(this))
+{
+    m_refreshTimer->setInterval(refreshInterval);
+
+    connect(m_refreshTimer, &QTimer::timeout, this, &DownloadManager::refresh);
+
+    m_thread->setObjectName(QStringLiteral("downloads"));
+
+    m_networkManager->moveToThread(m_thread);
+    m_tokenBucket->moveToThread(m_thread);
+
+    connect(m_thread, &QThread::finished, m_networkManager, &QObject::deleteLater);
+    connect(m_thread, &QThread::finished, m_tokenBucket, &QObject::deleteLater);
+
+    m_thread->start();
+
+    load();
+    loadCompleted();
+
+    QTimer::singleShot(0, this, &DownloadManager::schedule);
+}
+
+DownloadManager::~DownloadManager()
+{
+    save();
+
+    // Deferred deletions are still processed when the thread finishes, so the downloads can persist their state.
+    for (const auto& item : m_items)
+    {
+        if (item.download != nullptr)
+        {
+            disconnect(item.download, nullptr, this, nullptr);
+            connect(m_thread, &QThread::finished, item.download, &QObject::deleteLater);
+        }
+    }
+
+    m_thread->quit();
+    m_thread->wait();
+}
+
+int DownloadManager::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return 8;
+}
+
+QVariant DownloadManager::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+    {
+        return {};
+    }
+
+    if (orientation != Qt::Horizontal)
+    {
+        return {};
+    }
+
+    switch (section)
+    {
+    case 0:
+        return tr("Title");
+    case 1:
+        return tr("State");
+    case 2:
+        return tr("Progress");
+    case 3:
+        return tr("Size");
+    case 4:
+        return tr("Speed");
+    case 5:
+        return tr("Remaining");
+    case 6:
+        return tr("Priority");
+    case 7:
+        return tr("File");
+    default:
+        return {};
+    }
+}
+
+int DownloadManager::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return m_items.size();
+}
+
+QVariant DownloadManager::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_items.size())
+    {
+        return {};
+    }
+
+    const auto& item = m_items.at(index.row());
+
+    if (role == Qt::ToolTipRole)
+    {
+        if (item.state == Failed)
+        {
+            return item.error;
+        }
+
+        if (item.state == Completed && m_completed.contains(item.key))
+        {
+            const auto& checksum = m_completed.value(item.key).checksum;
+
+            if (!checksum.isEmpty())
+            {
+                return tr("SHA-256: %1").arg(QString::fromLatin1(checksum.toHex()));
+            }
+        }
+
+        return item.url.toString();
+    }
+
+    if (role != Qt::DisplayRole)
+    {
+        return {};
+    }
+
+    switch (index.column())
+    {
+    case 0:
+        return item.title;
+    case 1:
+        switch (item.state)
+        {
+        default:
+        case Queued:
+            return tr("Queued");
+        case Running:
+            return tr("Downloading");
+        case Paused:
+            return tr("Paused");
+        case Completed:
+            return tr("Completed");
+        case Failed:
+            return tr("Failed");
+        }
+    case 2:
+        if (item.bytesTotal > 0)
+        {
+            return tr("%1 %").arg(100 * item.bytesReceived / item.bytesTotal);
+        }
+
+        return formatSize(item.bytesReceived);
+    case 3:
+        if (item.bytesTotal >= 0)
+        {
+            return formatSize(item.bytesTotal);
+        }
+
+        return {};
+    case 4:
+        if (item.state == Running && item.bytesPerSecond > 0)
+        {
+            return formatRate(item.bytesPerSecond);
+        }
+
+        return {};
+    case 5:
+        if (item.state == Running && item.bytesPerSecond > 0 && item.bytesTotal > 0)
+        {
+            return formatDuration(qMax(qint64(0), item.bytesTotal - item.bytesReceived) / qint64(item.bytesPerSecond));
+        }
+
+        return {};
+    case 6:
+        return item.priority;
+    case 7:
+        return item.filePath;
+    default:
+        return {};
+    }
+}
+
+void DownloadManager::enqueue(const QString& title, const QUrl& url, const QString& filePath, const QByteArray& key)
+{
+    const auto existing = std::find_if(m_items.begin(), m_items.end(), [&](const Item& item)
+    {
+        return item.filePath == filePath;
+    });
+
+    if (existing != m_items.end())
+    {
+        if (existing->state != Running)
+        {
+            existing->url = url;
+            existing->key = key;
+            existing->state = Queued;
+
+            changed(existing - m_items.begin());
+        }
+    }
+    else
+    {
+        const Item item = { m_nextId++, title, url, filePath, key, 0, Queued, 0, -1, 0, 0.0, QString(), nullptr };
+
+        beginInsertRows({}, m_items.size(), m_items.size());
+
+        m_items.append(item);
+
+        endInsertRows();
+    }
+
+    save();
+    schedule();
+}
+
+DownloadManager::Check DownloadManager::check(const QByteArray& key, QString& filePath) const
+{
+    const auto completed = m_completed.find(key);
+
+    if (completed == m_completed.end())
+    {
+        return NotDownloaded;
+    }
+
+    filePath = completed->filePath;
+
+    const QFileInfo fileInfo(filePath);
+
+    if (!fileInfo.exists())
+    {
+        return NotDownloaded;
+    }
+
+    return fileInfo.size() == completed->size ? Downloaded : Corrupt;
+}
+
+void DownloadManager::pause(const QModelIndex& index)
+{
+    if (!index.isValid())
+    {
+        return;
+    }
+
+    auto& item = m_items[index.row()];
+
+    if (item.state != Running && item.state != Queued)
+    {
+        return;
+    }
+
+    stop(item);
+    item.state = Paused;
+
+    changed(index.row());
+
+    save();
+    schedule();
+}
+
+void DownloadManager::resume(const QModelIndex& index)
+{
+    if (!index.isValid())
+    {
+        return;
+    }
+
+    auto& item = m_items[index.row()];
+
+    if (item.state != Paused && item.state != Failed)
+    {
+        return;
+    }
+
+    item.state = Queued;
+
+    changed(index.row());
+
+    save();
+    schedule();
+}
+
+void DownloadManager::remove(const QModelIndex& index)
+{
+    if (!index.isValid())
+    {
+        return;
+    }
+
+    auto& item = m_items[index.row()];
+
+    const auto discard = item.state != Completed;
+
+    // A running download would save its state while being aborted, so it is discarded afterwards on the I/O thread.
+    if (item.download != nullptr)
+    {
+        stop(item, discard);
+    }
+    else if (discard)
+    {
+        Download::discard(item.filePath);
+    }
+
+    beginRemoveRows({}, index.row(), index.row());
+
+    m_items.remove(index.row());
+
+    endRemoveRows();
+
+    save();
+    schedule();
+}
+
+void DownloadManager::changePriority(const QModelIndex& index, const int delta)
+{
+    if (!index.isValid())
+    {
+        return;
+    }
+
+    m_items[index.row()].priority += delta;
+
+    changed(index.row());
+
+    save();
+    schedule();
+}
+
+void DownloadManager::schedule()
+{
+    const auto bandwidthLimit = qint64(m_settings.bandwidthLimit()) * 1024;
+
+    if (m_bandwidthLimit != bandwidthLimit)
+    {
+        m_bandwidthLimit = bandwidthLimit;
+
+        const auto tokenBucket = m_tokenBucket;
+
+        QTimer::singleShot(0, tokenBucket, [tokenBucket, bandwidthLimit]()
+        {
+            tokenBucket->setRate(bandwidthLimit);
+        });
+    }
+
+    const auto maximumDownloads = m_settings.maximumDownloads();
+    const auto maximumDownloadsPerHost = m_settings.maximumDownloadsPerHost();
+
+    auto running = 0;
+    QHash< QString, int > runningByHost;
+    QVector< int > queued;
+
+    for (int row = 0; row < m_items.size(); ++row)
+    {
+        const auto& item = m_items.at(row);
+
+        if (item.state == Running)
+        {
+            ++running;
+            ++runningByHost[item.url.host()];
+        }
+        else if (item.state == Queued)
+        {
+            queued.append(row);
+        }
+    }
+
+    // Higher priorities first, otherwise in the order the downloads were queued.
+    std::stable_sort(queued.begin(), queued.end(), [this](const int lhs, const int rhs)
+    {
+        return m_items.at(lhs).priority > m_items.at(rhs).priority;
+    });
+
+    for (const auto row : queued)
+    {
+        if (running >= maximumDownloads)
+        {
+            break;
+        }
+
+        auto& item = m_items[row];
+        auto& runningOnHost = runningByHost[item.url.host()];
+
+        if (runningOnHost >= maximumDownloadsPerHost)
+        {
+            continue;
+        }
+
+        start(item);
+
+        if (item.state == Running)
+        {
+            ++running;
+            ++runningOnHost;
+        }
+    }
+}
+
+int DownloadManager::rowOf(const quint64 id) const
+{
+    for (int row = 0; row < m_items.size(); ++row)
+    {
+        if (m_items.at(row).id == id)
+        {
+            return row;
+        }
+    }
+
+    return -1;
+}
+
+void DownloadManager::changed(const int row)
+{
+    emit dataChanged(index(row, 0), index(row, columnCount({}) - 1));
+}
+
+void DownloadManager::start(Item& item)
+{
+    const auto id = item.id;
+    const auto row = rowOf(id);
+
+    Transfer* download = nullptr;
+
+    if (HlsDownload::isPlaylist(item.url))
+    {
+        download = new HlsDownload(
+            m_networkManager, m_settings.userAgent(),
+            item.url, item.filePath,
+            m_settings.preferredUrl(), m_settings.downloadSegments(), m_tokenBucket);
+    }
+    else
+    {
+        download = new Download(
+            m_networkManager, m_settings.userAgent(),
+            item.url, item.filePath,
+            m_settings.downloadSegments(), m_tokenBucket);
+    }
+
+    download->setComputeChecksum(m_settings.computeChecksums());
+    download->moveToThread(m_thread);
+
+    connect(download, &Transfer::progress, this, [this, id](qint64 bytesReceived, qint64 bytesTotal)
+    {
+        progress(id, bytesReceived, bytesTotal);
+    });
+
+    connect(download, &Transfer::finished, this, [this, id](bool success)
+    {
+        finished(id, success);
+    });
+
+    QTimer::singleShot(0, download, [download]()
+    {
+        download->start();
+    });
+
+    item.state = Running;
+    item.bytesSampled = item.bytesReceived;
+    item.bytesPerSecond = 0.0;
+    item.error.clear();
+    item.download = download;
+
+    changed(row);
+
+    if (!m_refreshTimer->isActive())
+    {
+        m_sampleTimer.start();
+        m_refreshTimer->start();
+    }
+}
+
+void DownloadManager::stop(Item& item, const bool discard)
+{
+    if (item.download == nullptr)
+    {
+        return;
+    }
+
+    // Aborting keeps the partial data so that the download can be resumed later on unless it is discarded.
+    disconnect(item.download, nullptr, this, nullptr);
+
+    const auto download = item.download;
+    const auto filePath = item.filePath;
+
+    QTimer::singleShot(0, download, [download, discard, filePath]()
+    {
+        download->abort();
+        download->deleteLater();
+
+        if (discard)
+        {
+            Download::discard(filePath);
+        }
+    });
+
+    item.download = nullptr;
+}
+
+void DownloadManager::progress(const quint64 id, const qint64 bytesReceived, const qint64 bytesTotal)
+{
+    const auto row = rowOf(id);
+
+    if (row < 0)
+    {
+        return;
+    }
+
+    auto& item = m_items[row];
+
+    item.bytesReceived = bytesReceived;
+    item.bytesTotal = bytesTotal;
+}
+
+void DownloadManager::finished(const quint64 id, const bool success)
+{
+    const auto row = rowOf(id);
+
+    if (row < 0)
+    {
+        return;
+    }
+
+    auto& item = m_items[row];
+
+    item.state = success ? Completed : Failed;
+    item.error = item.download->errorString();
+
+    if (success && !item.key.isEmpty())
+    {
+        const Completed completed = { item.filePath, QFileInfo(item.filePath).size(), item.download->checksum() };
+
+        m_completed.insert(item.key, completed);
+
+        saveCompleted();
+    }
+
+    item.download->deleteLater();
+    item.download = nullptr;
+
+    changed(row);
+
+    save();
+    schedule();
+}
+
+void DownloadManager::refresh()
+{
+    const auto elapsed = m_sampleTimer.restart();
+
+    auto firstRow = m_items.size();
+    auto lastRow = -1;
+
+    qint64 bytesReceived = 0;
+    qint64 bytesTotal = 0;
+    double bytesPerSecond = 0.0;
+
+    for (int row = 0; row < m_items.size(); ++row)
+    {
+        auto& item = m_items[row];
+
+        if (item.state != Running)
+        {
+            continue;
+        }
+
+        if (elapsed > 0)
+        {
+            const auto sample = qMax(0.0, (item.bytesReceived - item.bytesSampled) * 1000.0 / elapsed);
+
+            item.bytesPerSecond = item.bytesPerSecond > 0.0 ? item.bytesPerSecond + throughputSmoothing * (sample - item.bytesPerSecond) : sample;
+        }
+
+        item.bytesSampled = item.bytesReceived;
+
+        firstRow = qMin(firstRow, row);
+        lastRow = qMax(lastRow, row);
+
+        bytesReceived += item.bytesReceived;
+        bytesPerSecond += item.bytesPerSecond;
+
+        // The total is unknown as long as the size of any running download is.
+        if (bytesTotal >= 0)
+        {
+            bytesTotal = item.bytesTotal >= 0 ? bytesTotal + item.bytesTotal : -1;
+        }
+    }
+
+    if (lastRow >= 0)
+    {
+        emit dataChanged(index(firstRow, 2), index(lastRow, 5));
+    }
+    else
+    {
+        m_refreshTimer->stop();
+    }
+
+    emit progressChanged(bytesReceived, bytesTotal, qint64(bytesPerSecond));
+}
+
+void DownloadManager::load()
+{
+    QFile file(dataFilePath(queueName));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+
+    const auto items = QJsonDocument::fromJson(file.readAll()).array();
+
+    for (const auto& value : items)
+    {
+        const auto object = value.toObject();
+
+        auto state = State(object.value(Keys::state).toInt());
+
+        // Downloads which were running when the application exited are resumed.
+        if (state == Running)
+        {
+            state = Queued;
+        }
+
+        const Item item =
+        {
+            m_nextId++,
+            object.value(Keys::title).toString(),
+            QUrl(object.value(Keys::url).toString()),
+            object.value(Keys::filePath).toString(),
+            QByteArray::fromHex(object.value(Keys::key).toString().toLatin1()),
+            object.value(Keys::priority).toInt(),
+            state,
+            qint64(object.value(Keys::bytesReceived).toDouble()),
+            qint64(object.value(Keys::bytesTotal).toDouble(-1)),
+            0,
+            0.0,
+            object.value(Keys::error).toString(),
+            nullptr
+        };
+
+        m_items.append(item);
+    }
+}
+
+void DownloadManager::save() const
+{
+    QJsonArray items;
+
+    for (const auto& item : m_items)
+    {
+        QJsonObject object;
+
+        object.insert(Keys::title, item.title);
+        object.insert(Keys::url, item.url.toString());
+        object.insert(Keys::filePath, item.filePath);
+        object.insert(Keys::key, QString::fromLatin1(item.key.toHex()));
+        object.insert(Keys::priority, item.priority);
+        object.insert(Keys::state, int(item.state));
+        object.insert(Keys::bytesReceived, double(item.bytesReceived));
+        object.insert(Keys::bytesTotal, double(item.bytesTotal));
+        object.insert(Keys::error, item.error);
+
+        items.append(object);
+    }
+
+    QSaveFile file(dataFilePath(queueName));
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    file.write(QJsonDocument(items).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void DownloadManager::loadCompleted()
+{
+    QFile file(dataFilePath(completedName));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+
+    const auto entries = QJsonDocument::fromJson(file.readAll()).object();
+
+    for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+    {
+        const auto object = entry.value().toObject();
+
+        const Completed completed =
+        {
+            object.value(Keys::filePath).toString(),
+            qint64(object.value(Keys::size).toDouble(-1)),
+            QByteArray::fromHex(object.value(Keys::checksum).toString().toLatin1())
+        };
+
+        m_completed.insert(QByteArray::fromHex(entry.key().toLatin1()), completed);
+    }
+}
+
+void DownloadManager::saveCompleted() const
+{
+    QJsonObject entries;
+
+    for (auto completed = m_completed.begin(); completed != m_completed.end(); ++completed)
+    {
+        QJsonObject object;
+
+        object.insert(Keys::filePath, completed->filePath);
+        object.insert(Keys::size, double(completed->size));
+
+        if (!completed->checksum.isEmpty())
+        {
+            object.insert(Keys::checksum, QString::fromLatin1(completed->checksum.toHex()));
+        }
+
+        entries.insert(QString::fromLatin1(completed.key().toHex()), object);
+    }
+
+    QSaveFile file(dataFilePath(completedName));
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    file.write(QJsonDocument(entries).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+} // QMediathekView
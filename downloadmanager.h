@@ -0,0 +1,163 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DOWNLOADMANAGER_H
+#define DOWNLOADMANAGER_H
+
+#include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QThread;
+class QTimer;
+
+namespace QMediathekView
+{
+
+class Settings;
+class Transfer;
+class TokenBucket;
+
+class DownloadManager : public QAbstractTableModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(DownloadManager)
+
+public:
+    DownloadManager(const Settings& settings, QObject* parent = 0);
+    ~DownloadManager();
+
+    enum State
+    {
+        Queued,
+        Running,
+        Paused,
+        Completed,
+        Failed
+    };
+
+    enum Check
+    {
+        NotDownloaded,
+        Downloaded,
+        Corrupt
+    };
+
+signals:
+    // Aggregated over all running downloads and emitted at a fixed rate while any of them is running.
+    void progressChanged(qint64 bytesReceived, qint64 bytesTotal, qint64 bytesPerSecond);
+
+public:
+    int columnCount(const QModelIndex& parent) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+    int rowCount(const QModelIndex& parent) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+public:
+    // The key identifies the show and URL variant so that completed downloads can be recognized.
+    void enqueue(const QString& title, const QUrl& url, const QString& filePath, const QByteArray& key = QByteArray());
+
+    // Only compares the size of the file as it must be cheap enough to be called before every download.
+    Check check(const QByteArray& key, QString& filePath) const;
+
+    void pause(const QModelIndex& index);
+    void resume(const QModelIndex& index);
+    void remove(const QModelIndex& index);
+
+    void changePriority(const QModelIndex& index, const int delta);
+
+    // Starts queued downloads as far as the configured limits allow.
+    void schedule();
+
+private:
+    struct Item
+    {
+        quint64 id;
+
+        QString title;
+        QUrl url;
+        QString filePath;
+        QByteArray key;
+
+        int priority;
+        State state;
+
+        qint64 bytesReceived;
+        qint64 bytesTotal;
+
+        qint64 bytesSampled;
+        double bytesPerSecond;
+
+        QString error;
+
+        Transfer* download;
+    };
+
+    const Settings& m_settings;
+
+    // Network reads and file writes of all downloads happen in this thread.
+    QThread* m_thread;
+
+    QNetworkAccessManager* m_networkManager;
+    TokenBucket* m_tokenBucket;
+    qint64 m_bandwidthLimit;
+
+    QVector< Item > m_items;
+    quint64 m_nextId;
+
+    struct Completed
+    {
+        QString filePath;
+        qint64 size;
+        QByteArray checksum;
+    };
+
+    QHash< QByteArray, Completed > m_completed;
+
+    // Progress notifications only update the items, the view is refreshed by this timer.
+    QTimer* m_refreshTimer;
+    QElapsedTimer m_sampleTimer;
+
+    int rowOf(const quint64 id) const;
+    void changed(const int row);
+
+    void start(Item& item);
+    void stop(Item& item, const bool discard = false);
+
+    void progress(const quint64 id, const qint64 bytesReceived, const qint64 bytesTotal);
+    void finished(const quint64 id, const bool success);
+
+    void refresh();
+
+    void load();
+    void save() const;
+
+    void loadCompleted();
+    void saveCompleted() const;
+
+};
+
+} // QMediathekView
+
+#endif // DOWNLOADMANAGER_H
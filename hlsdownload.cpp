@@ -0,0 +1,725 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "hlsdownload.h"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+
+#include "tokenbucket.h"
+#include "trace.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto maximumPlaylistDepth = 1;
+
+constexpr auto maximumRetries = 3;
+constexpr auto retryDelay = 1000;
+
+constexpr auto progressInterval = 100;
+
+constexpr qint64 readBufferSize = 1024 * 1024;
+
+QString partialFilePath(const QString& filePath)
+{
+    return filePath + QStringLiteral(".part");
+}
+
+// Splits an attribute list like 'BANDWIDTH=1280000,CODECS="avc1.4d401f,mp4a.40.2"' ignoring commas within quotes.
+QHash< QByteArray, QByteArray > parseAttributes(const QByteArray& list)
+{
+    QHash< QByteArray, QByteArray > attributes;
+
+    auto quoted = false;
+    auto begin = 0;
+
+    for (int index = 0; index <= list.size(); ++index)
+    {
+        if (index < list.size() && list.at(index) == '"')
+        {
+            quoted = !quoted;
+            continue;
+        }
+
+        if (index < list.size() && (quoted || list.at(index) != ','))
+        {
+            continue;
+        }
+
+        const auto attribute = list.mid(begin, index - begin);
+        const auto equals = attribute.indexOf('=');
+
+        if (equals > 0)
+        {
+            auto value = attribute.mid(equals + 1).trimmed();
+
+            if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"'))
+            {
+                value = value.mid(1, value.size() - 2);
+            }
+
+            attributes.insert(attribute.left(equals).trimmed(), value);
+        }
+
+        begin = index + 1;
+    }
+
+    return attributes;
+}
+
+// Parses a byte range of the form "<length>[@<offset>]" where a missing offset is returned as -1.
+bool parseByteRange(const QByteArray& range, qint64& length, qint64& offset)
+{
+    const auto at = range.indexOf('@');
+
+    bool ok = false;
+
+    length = range.left(at).toLongLong(&ok);
+
+    if (!ok)
+    {
+        return false;
+    }
+
+    offset = -1;
+
+    if (at >= 0)
+    {
+        offset = range.mid(at + 1).toLongLong(&ok);
+    }
+
+    return ok;
+}
+
+void stop(QObject* receiver, QNetworkReply* reply)
+{
+    QObject::disconnect(reply, nullptr, receiver, nullptr);
+
+    reply->abort();
+    reply->deleteLater();
+}
+
+} // anonymous
+
+HlsDownload::HlsDownload(
+    QNetworkAccessManager* networkManager,
+    const QString& userAgent,
+    const QUrl& url,
+    const QString& filePath,
+    const Url variant,
+    const int window,
+    TokenBucket* tokenBucket,
+    QObject* parent)
+    : Transfer(parent)
+    , m_networkManager(networkManager)
+    , m_userAgent(userAgent)
+    , m_url(url)
+    , m_filePath(filePath)
+    , m_variant(variant)
+    , m_window(qMax(1, window))
+    , m_tokenBucket(tokenBucket)
+    , m_file(new QFile(partialFilePath(filePath)))
+    , m_nextFetch(0)
+    , m_nextWrite(0)
+    , m_bytesReceived(0)
+    , m_bytesWritten(0)
+    , m_hash(QCryptographicHash::Sha256)
+    , m_finished(false)
+{
+    if (m_tokenBucket != nullptr)
+    {
+        connect(m_tokenBucket, &TokenBucket::refilled, this, &HlsDownload::drain);
+    }
+}
+
+HlsDownload::~HlsDownload()
+{
+    if (!m_finished)
+    {
+        if (m_playlistReply != nullptr)
+        {
+            stop(this, m_playlistReply);
+        }
+
+        for (const auto& fetch : m_fetches)
+        {
+            if (fetch.second->reply != nullptr)
+            {
+                stop(this, fetch.second->reply);
+            }
+        }
+
+        m_file->remove();
+    }
+}
+
+bool HlsDownload::isPlaylist(const QUrl& url)
+{
+    return url.path().endsWith(QStringLiteral(".m3u8"), Qt::CaseInsensitive);
+}
+
+void HlsDownload::start()
+{
+    if (!m_file->open(QIODevice::WriteOnly))
+    {
+        m_finished = true;
+        m_errorString = m_file->errorString();
+
+        emit finished(false);
+        return;
+    }
+
+    reportProgress(true);
+
+    fetchPlaylist(m_url, 0);
+}
+
+void HlsDownload::abort()
+{
+    fail(tr("Download was canceled."));
+}
+
+QString HlsDownload::errorString() const
+{
+    return m_errorString;
+}
+
+bool HlsDownload::parse(const QByteArray& data, const QUrl& baseUrl, Playlist& playlist)
+{
+    playlist.variants.clear();
+    playlist.segments.clear();
+    playlist.encrypted = false;
+
+    const auto lines = data.split('\n');
+
+    if (lines.isEmpty() || !lines.first().trimmed().startsWith("#EXTM3U"))
+    {
+        return false;
+    }
+
+    auto streamInformation = false;
+    qint64 bandwidth = 0;
+
+    qint64 length = -1;
+    qint64 offset = -1;
+
+    QUrl previousUrl;
+    qint64 previousEnd = 0;
+
+    for (const auto& rawLine : lines)
+    {
+        const auto line = rawLine.trimmed();
+
+        if (line.isEmpty())
+        {
+            continue;
+        }
+
+        if (line.startsWith("#EXT-X-STREAM-INF:"))
+        {
+            const auto attributes = parseAttributes(line.mid(line.indexOf(':') + 1));
+
+            streamInformation = true;
+            bandwidth = attributes.value("BANDWIDTH").toLongLong();
+        }
+        else if (line.startsWith("#EXT-X-BYTERANGE:"))
+        {
+            if (!parseByteRange(line.mid(line.indexOf(':') + 1), length, offset))
+            {
+                return false;
+            }
+        }
+        else if (line.startsWith("#EXT-X-KEY:"))
+        {
+            const auto attributes = parseAttributes(line.mid(line.indexOf(':') + 1));
+
+            playlist.encrypted = attributes.value("METHOD") != "NONE";
+        }
+        else if (line.startsWith("#EXT-X-MAP:"))
+        {
+            // The initialization section of fragmented MP4 streams simply precedes the media segments.
+            const auto attributes = parseAttributes(line.mid(line.indexOf(':') + 1));
+
+            qint64 mapLength = -1;
+            qint64 mapOffset = -1;
+
+            if (attributes.contains("BYTERANGE") && !parseByteRange(attributes.value("BYTERANGE"), mapLength, mapOffset))
+            {
+                return false;
+            }
+
+            const Segment segment = { baseUrl.resolved(QUrl(QString::fromUtf8(attributes.value("URI")))), qMax(qint64(0), mapOffset), mapLength };
+
+            playlist.segments.append(segment);
+        }
+        else if (!line.startsWith('#'))
+        {
+            const auto url = baseUrl.resolved(QUrl(QString::fromUtf8(line)));
+
+            if (streamInformation)
+            {
+                const Variant variant = { url, bandwidth };
+
+                playlist.variants.append(variant);
+
+                streamInformation = false;
+            }
+            else
+            {
+                // A byte range without offset continues where the previous one of the same resource ended.
+                if (length >= 0 && offset < 0)
+                {
+                    offset = url == previousUrl ? previousEnd : 0;
+                }
+
+                const Segment segment = { url, qMax(qint64(0), offset), length };
+
+                playlist.segments.append(segment);
+
+                previousUrl = url;
+                previousEnd = segment.offset + segment.length;
+
+                length = -1;
+                offset = -1;
+            }
+        }
+    }
+
+    return true;
+}
+
+QNetworkReply* HlsDownload::get(const QUrl& url, const qint64 offset, const qint64 length)
+{
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, m_userAgent);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+
+    if (length >= 0)
+    {
+        request.setRawHeader("Range", QByteArrayLiteral("bytes=") + QByteArray::number(offset) + '-' + QByteArray::number(offset + length - 1));
+    }
+
+    const auto reply = m_networkManager->get(request);
+
+    reply->setReadBufferSize(readBufferSize);
+
+    return reply;
+}
+
+void HlsDownload::fetchPlaylist(const QUrl& url, const int depth)
+{
+    const auto reply = get(url);
+
+    m_playlistReply = reply;
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, depth]()
+    {
+        playlistFetched(reply, depth);
+    });
+}
+
+void HlsDownload::playlistFetched(QNetworkReply* reply, const int depth)
+{
+    m_playlistReply = nullptr;
+    reply->deleteLater();
+
+    if (reply->error() != QNetworkReply::NoError)
+    {
+        fail(reply->errorString());
+        return;
+    }
+
+    Playlist playlist;
+
+    // Relative URIs are resolved against the playlist's location after redirects.
+    if (!parse(reply->readAll(), reply->url(), playlist))
+    {
+        fail(tr("Received a malformed playlist."));
+        return;
+    }
+
+    if (!playlist.variants.isEmpty())
+    {
+        if (depth >= maximumPlaylistDepth)
+        {
+            fail(tr("Received a malformed playlist."));
+            return;
+        }
+
+        auto& variants = playlist.variants;
+
+        std::stable_sort(variants.begin(), variants.end(), [](const Variant& lhs, const Variant& rhs)
+        {
+            return lhs.bandwidth < rhs.bandwidth;
+        });
+
+        auto variant = variants.constBegin();
+
+        switch (m_variant)
+        {
+        default:
+        case Url::Default:
+            variant += (variants.size() - 1) / 2;
+            break;
+        case Url::Small:
+            break;
+        case Url::Large:
+            variant += variants.size() - 1;
+            break;
+        }
+
+        fetchPlaylist(variant->url, depth + 1);
+        return;
+    }
+
+    if (playlist.encrypted)
+    {
+        fail(tr("Encrypted streams are not supported."));
+        return;
+    }
+
+    if (playlist.segments.isEmpty())
+    {
+        fail(tr("The playlist does not contain any segments."));
+        return;
+    }
+
+    m_segments = playlist.segments;
+
+    fetchSegments();
+}
+
+void HlsDownload::fetchSegments()
+{
+    // Bounding the window also bounds the memory used for segments which cannot be written yet.
+    while (m_nextFetch < m_segments.size() && m_nextFetch < m_nextWrite + m_window)
+    {
+        startFetch(m_nextFetch++);
+    }
+}
+
+void HlsDownload::startFetch(const int index)
+{
+    auto& fetch = m_fetches[index];
+
+    if (!fetch)
+    {
+        fetch.reset(new Fetch);
+    }
+
+    const auto& segment = m_segments.at(index);
+    const auto reply = get(segment.url, segment.offset, segment.length);
+
+    fetch->reply = reply;
+    fetch->data.clear();
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, index]()
+    {
+        readFetch(index);
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [this, index]()
+    {
+        finishFetch(index);
+    });
+}
+
+void HlsDownload::readFetch(const int index)
+{
+    TRACE_SCOPE("HlsDownload::readFetch");
+
+    const auto entry = m_fetches.find(index);
+
+    if (entry == m_fetches.end())
+    {
+        return;
+    }
+
+    auto& fetch = *entry->second;
+    QNetworkReply* const reply = fetch.reply;
+
+    if (reply == nullptr || reply->error() != QNetworkReply::NoError)
+    {
+        return;
+    }
+
+    auto available = reply->bytesAvailable();
+
+    if (m_tokenBucket != nullptr)
+    {
+        available = m_tokenBucket->take(available);
+    }
+
+    const auto data = reply->read(available);
+
+    fetch.data.append(data);
+    m_bytesReceived += data.size();
+
+    reportProgress(false);
+}
+
+void HlsDownload::finishFetch(const int index)
+{
+    const auto entry = m_fetches.find(index);
+
+    if (entry == m_fetches.end())
+    {
+        return;
+    }
+
+    auto& fetch = *entry->second;
+    QNetworkReply* const reply = fetch.reply;
+
+    if (reply == nullptr)
+    {
+        return;
+    }
+
+    auto error = reply->errorString();
+
+    if (reply->error() == QNetworkReply::NoError)
+    {
+        readFetch(index);
+
+        // Throttled data is drained once the token bucket has been refilled.
+        if (m_finished || reply->bytesAvailable() > 0)
+        {
+            return;
+        }
+
+        const auto contentLength = reply->header(QNetworkRequest::ContentLengthHeader);
+
+        if (!contentLength.isValid() || contentLength.toLongLong() == fetch.data.size())
+        {
+            const auto& segment = m_segments.at(index);
+            const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+            // A server ignoring the byte range sends the whole resource.
+            if (segment.length >= 0 && status != 206)
+            {
+                fetch.data = fetch.data.mid(segment.offset, segment.length);
+            }
+
+            fetch.reply = nullptr;
+            fetch.done = true;
+            reply->deleteLater();
+
+            if (!writeCompleted())
+            {
+                fail(m_file->errorString());
+                return;
+            }
+
+            if (m_nextWrite == m_segments.size())
+            {
+                complete();
+                return;
+            }
+
+            fetchSegments();
+            return;
+        }
+
+        error = tr("Received an incomplete segment.");
+    }
+
+    m_bytesReceived -= fetch.data.size();
+
+    fetch.reply = nullptr;
+    fetch.data.clear();
+    reply->deleteLater();
+
+    if (fetch.retries < maximumRetries)
+    {
+        QTimer::singleShot(retryDelay << fetch.retries++, this, [this, index]()
+        {
+            if (!m_finished)
+            {
+                startFetch(index);
+            }
+        });
+
+        return;
+    }
+
+    fail(error);
+}
+
+void HlsDownload::drain()
+{
+    QVector< int > indexes;
+
+    for (const auto& fetch : m_fetches)
+    {
+        if (fetch.second->reply != nullptr)
+        {
+            indexes.append(fetch.first);
+        }
+    }
+
+    for (const auto index : indexes)
+    {
+        if (m_finished)
+        {
+            return;
+        }
+
+        const auto entry = m_fetches.find(index);
+
+        if (entry == m_fetches.end() || entry->second->reply == nullptr)
+        {
+            continue;
+        }
+
+        QNetworkReply* const reply = entry->second->reply;
+
+        if (reply->bytesAvailable() > 0)
+        {
+            readFetch(index);
+        }
+
+        if (reply->isFinished() && reply->bytesAvailable() == 0)
+        {
+            finishFetch(index);
+        }
+    }
+}
+
+bool HlsDownload::writeCompleted()
+{
+    // Segments are written strictly in order, so later ones wait until all earlier ones are complete.
+    for (auto entry = m_fetches.find(m_nextWrite); entry != m_fetches.end() && entry->second->done; entry = m_fetches.find(m_nextWrite))
+    {
+        const auto& data = entry->second->data;
+
+        if (m_file->write(data) != data.size())
+        {
+            return false;
+        }
+
+        m_bytesWritten += data.size();
+
+        if (computeChecksum())
+        {
+            m_hash.addData(data);
+        }
+
+        m_fetches.erase(entry);
+        ++m_nextWrite;
+    }
+
+    return true;
+}
+
+void HlsDownload::reportProgress(const bool force)
+{
+    if (!force && m_progressTimer.isValid() && m_progressTimer.elapsed() < progressInterval)
+    {
+        return;
+    }
+
+    m_progressTimer.start();
+
+    // The total size is extrapolated from the segments written so far.
+    const auto bytesTotal = m_nextWrite > 0 ? m_bytesWritten * m_segments.size() / m_nextWrite : -1;
+
+    emit progress(m_bytesReceived, qMax(bytesTotal, m_bytesReceived));
+}
+
+void HlsDownload::fail(const QString& error)
+{
+    if (m_finished)
+    {
+        return;
+    }
+
+    m_finished = true;
+    m_errorString = error;
+
+    if (m_playlistReply != nullptr)
+    {
+        stop(this, m_playlistReply);
+    }
+
+    for (const auto& fetch : m_fetches)
+    {
+        if (fetch.second->reply != nullptr)
+        {
+            stop(this, fetch.second->reply);
+        }
+    }
+
+    m_fetches.clear();
+
+    m_file->close();
+    m_file->remove();
+
+    emit finished(false);
+}
+
+void HlsDownload::complete()
+{
+    m_finished = true;
+
+    reportProgress(true);
+
+    if (!m_file->flush())
+    {
+        m_errorString = m_file->errorString();
+
+        m_file->close();
+        m_file->remove();
+
+        emit finished(false);
+        return;
+    }
+
+    if (computeChecksum())
+    {
+        setChecksum(m_hash.result());
+    }
+
+    m_file->close();
+
+    QFile::remove(m_filePath);
+
+    if (!m_file->rename(m_filePath))
+    {
+        m_errorString = m_file->errorString();
+
+        emit finished(false);
+        return;
+    }
+
+    emit finished(true);
+}
+
+} // QMediathekView
@@ -0,0 +1,155 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef HLSDOWNLOAD_H
+#define HLSDOWNLOAD_H
+
+#include <map>
+#include <memory>
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+#include "schema.h"
+#include "transfer.h"
+
+class QFile;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace QMediathekView
+{
+
+class TokenBucket;
+
+// Downloads the media segments listed by an HTTP Live Streaming playlist into a single file.
+class HlsDownload : public Transfer
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HlsDownload)
+
+public:
+    HlsDownload(
+        QNetworkAccessManager* networkManager,
+        const QString& userAgent,
+        const QUrl& url,
+        const QString& filePath,
+        const Url variant,
+        const int window,
+        TokenBucket* tokenBucket,
+        QObject* parent = 0);
+    ~HlsDownload();
+
+    static bool isPlaylist(const QUrl& url);
+
+public:
+    void start() override;
+    void abort() override;
+
+    QString errorString() const override;
+
+public:
+    struct Variant
+    {
+        QUrl url;
+        qint64 bandwidth;
+    };
+
+    struct Segment
+    {
+        QUrl url;
+        qint64 offset;
+        qint64 length;
+    };
+
+    struct Playlist
+    {
+        QVector< Variant > variants;
+        QVector< Segment > segments;
+        bool encrypted;
+    };
+
+    static bool parse(const QByteArray& data, const QUrl& baseUrl, Playlist& playlist);
+
+private:
+    struct Fetch
+    {
+        QPointer< QNetworkReply > reply;
+        QByteArray data;
+        bool done = false;
+        int retries = 0;
+    };
+
+    QNetworkReply* get(const QUrl& url, const qint64 offset = 0, const qint64 length = -1);
+
+    void fetchPlaylist(const QUrl& url, const int depth);
+    void playlistFetched(QNetworkReply* reply, const int depth);
+
+    void fetchSegments();
+    void startFetch(const int index);
+    void readFetch(const int index);
+    void finishFetch(const int index);
+    void drain();
+
+    bool writeCompleted();
+    void reportProgress(const bool force);
+
+    void fail(const QString& error);
+    void complete();
+
+private:
+    QNetworkAccessManager* m_networkManager;
+
+    const QString m_userAgent;
+    const QUrl m_url;
+    const QString m_filePath;
+    const Url m_variant;
+    const int m_window;
+
+    TokenBucket* m_tokenBucket;
+
+    std::unique_ptr< QFile > m_file;
+
+    QPointer< QNetworkReply > m_playlistReply;
+    QVector< Segment > m_segments;
+
+    std::map< int, std::unique_ptr< Fetch > > m_fetches;
+    int m_nextFetch;
+    int m_nextWrite;
+
+    qint64 m_bytesReceived;
+    qint64 m_bytesWritten;
+
+    QCryptographicHash m_hash;
+
+    QElapsedTimer m_progressTimer;
+
+    bool m_finished;
+    QString m_errorString;
+
+};
+
+} // QMediathekView
+
+#endif // HLSDOWNLOAD_H
@@ -22,6 +22,7 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #include "mainwindow.h"
 
 #include <QComboBox>
+#include <QCompleter>
 #include <QDockWidget>
 #include <QFormLayout>
 #include <QGridLayout>
@@ -30,6 +31,7 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #include <QLabel>
 #include <QPushButton>
 #include <QShortcut>
+#include <QSpinBox>
 #include <QStatusBar>
 #include <QTableView>
 #include <QTextEdit>
@@ -37,9 +39,12 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "settings.h"
 #include "model.h"
+#include "completionmodel.h"
+#include "downloadmanager.h"
 #include "miscellaneous.h"
 #include "settingsdialog.h"
 #include "application.h"
+#include "trace.h"
 
 namespace QMediathekView
 {
@@ -55,6 +60,29 @@ constexpr auto searchTimeout = 200;
 constexpr auto minimumChannelLength = 4;
 constexpr auto minimumTopicLength = 12;
 
+constexpr auto maximumDurationMinutes = 24 * 60 - 1;
+
+struct TimeRange
+{
+    const char* name;
+    QTime from;
+    QTime to;
+};
+
+const TimeRange timeRanges[] =
+{
+    { QT_TRANSLATE_NOOP("QMediathekView::MainWindow", "Any time"), QTime(), QTime() },
+    { QT_TRANSLATE_NOOP("QMediathekView::MainWindow", "Morning"), QTime(6, 0), QTime(11, 59, 59) },
+    { QT_TRANSLATE_NOOP("QMediathekView::MainWindow", "Afternoon"), QTime(12, 0), QTime(17, 59, 59) },
+    { QT_TRANSLATE_NOOP("QMediathekView::MainWindow", "Evening"), QTime(18, 0), QTime(23, 59, 59) },
+    { QT_TRANSLATE_NOOP("QMediathekView::MainWindow", "Night"), QTime(0, 0), QTime(5, 59, 59) }
+};
+
+QTime fromMinutes(const int minutes)
+{
+    return minutes != 0 ? QTime(minutes / 60, minutes % 60) : QTime();
+}
+
 template< typename Action >
 void forEachSelectedRow(const QAbstractItemView* view, Action action)
 {
@@ -66,12 +94,26 @@ void forEachSelectedRow(const QAbstractItemView* view, Action action)
     }
 }
 
+// Replaces the default completer which matches linearly against every item of the combo box.
+void setCompletions(QComboBox* box, CompletionModel* completions)
+{
+    const auto completer = new QCompleter(completions, box);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+
+    box->setCompleter(0);
+    box->lineEdit()->setCompleter(completer);
+
+    // The line edit shows the completer's popup right after emitting this signal.
+    QObject::connect(box->lineEdit(), &QLineEdit::textEdited, completions, &CompletionModel::complete);
+}
+
 } // anonymous
 
-MainWindow::MainWindow(Settings& settings, Model& model, Application& application, QWidget* parent)
+MainWindow::MainWindow(Settings& settings, Model& model, DownloadManager& downloadManager, Application& application, QWidget* parent)
     : QMainWindow(parent)
     , m_settings(settings)
     , m_model(model)
+    , m_downloadManager(downloadManager)
     , m_application(application)
 {
     m_tableView = new QTableView(this);
@@ -112,6 +154,7 @@ MainWindow::MainWindow(Settings& settings, Model& model, Application& applicatio
     m_channelBox->setEditable(true);
     m_channelBox->setMinimumContentsLength(minimumChannelLength);
     m_channelBox->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLength);
+    setCompletions(m_channelBox, m_model.channelCompletions());
     searchLayout->addRow(tr("Channel"), m_channelBox);
 
     m_topicBox = new QComboBox(searchWidget);
@@ -119,18 +162,69 @@ MainWindow::MainWindow(Settings& settings, Model& model, Application& applicatio
     m_topicBox->setEditable(true);
     m_topicBox->setMinimumContentsLength(minimumTopicLength);
     m_topicBox->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLength);
+    setCompletions(m_topicBox, m_model.topicCompletions());
     searchLayout->addRow(tr("Topic"), m_topicBox);
 
     m_titleEdit = new QLineEdit(searchWidget);
     m_titleEdit->setFocus();
     searchLayout->addRow(tr("Title"), m_titleEdit);
 
+    m_channelsButton = new ChannelsButton(m_model.channels(), searchWidget);
+    searchLayout->addRow(tr("Only channels"), m_channelsButton);
+
+    m_dateBox = new QComboBox(searchWidget);
+    m_dateBox->addItem(tr("Any day"), -1);
+    m_dateBox->addItem(tr("Today"), 0);
+    m_dateBox->addItem(tr("Since yesterday"), 1);
+    m_dateBox->addItem(tr("Last 7 days"), 7);
+    m_dateBox->addItem(tr("Last 30 days"), 30);
+    searchLayout->addRow(tr("Date"), m_dateBox);
+
+    m_timeBox = new QComboBox(searchWidget);
+
+    for (const auto& timeRange : timeRanges)
+    {
+        m_timeBox->addItem(tr(timeRange.name));
+    }
+
+    searchLayout->addRow(tr("Time"), m_timeBox);
+
+    const auto durationWidget = new QWidget(searchWidget);
+    searchLayout->addRow(tr("Duration"), durationWidget);
+
+    const auto durationLayout = new QBoxLayout(QBoxLayout::LeftToRight, durationWidget);
+    durationLayout->setContentsMargins(0, 0, 0, 0);
+    durationWidget->setLayout(durationLayout);
+
+    m_minimumDurationBox = new QSpinBox(durationWidget);
+    m_minimumDurationBox->setRange(0, maximumDurationMinutes);
+    m_minimumDurationBox->setPrefix(tr("at least "));
+    m_minimumDurationBox->setSuffix(tr(" min"));
+    m_minimumDurationBox->setSpecialValueText(tr("Any length"));
+    durationLayout->addWidget(m_minimumDurationBox);
+
+    m_maximumDurationBox = new QSpinBox(durationWidget);
+    m_maximumDurationBox->setRange(0, maximumDurationMinutes);
+    m_maximumDurationBox->setPrefix(tr("at most "));
+    m_maximumDurationBox->setSuffix(tr(" min"));
+    m_maximumDurationBox->setSpecialValueText(tr("Any length"));
+    durationLayout->addWidget(m_maximumDurationBox);
+
     connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::timeout);
 
     constexpr auto startTimer = static_cast< void (QTimer::*)() >(&QTimer::start);
     connect(m_channelBox, &QComboBox::currentTextChanged, m_searchTimer, startTimer);
     connect(m_topicBox, &QComboBox::currentTextChanged, m_searchTimer, startTimer);
     connect(m_titleEdit, &QLineEdit::textChanged, m_searchTimer, startTimer);
+    connect(m_channelsButton, &ChannelsButton::selectionChanged, m_searchTimer, startTimer);
+
+    constexpr auto currentIndexChanged = static_cast< void (QComboBox::*)(int) >(&QComboBox::currentIndexChanged);
+    connect(m_dateBox, currentIndexChanged, m_searchTimer, startTimer);
+    connect(m_timeBox, currentIndexChanged, m_searchTimer, startTimer);
+
+    constexpr auto valueChanged = static_cast< void (QSpinBox::*)(int) >(&QSpinBox::valueChanged);
+    connect(m_minimumDurationBox, valueChanged, m_searchTimer, startTimer);
+    connect(m_maximumDurationBox, valueChanged, m_searchTimer, startTimer);
 
     const auto buttonsWidget = new QWidget(searchWidget);
     searchLayout->addWidget(buttonsWidget);
@@ -196,14 +290,109 @@ MainWindow::MainWindow(Settings& settings, Model& model, Application& applicatio
     connect(m_downloadButton, &UrlButton::largeTriggered, this, &MainWindow::downloadLargeTriggered);
     connect(m_tableView->selectionModel(), &QItemSelectionModel::currentChanged, m_downloadButton, &UrlButton::currentChanged);
 
+    const auto downloadsDock = new QDockWidget(tr("Downloads"), this);
+    downloadsDock->setObjectName(QStringLiteral("downloadsDock"));
+    addDockWidget(Qt::BottomDockWidgetArea, downloadsDock);
+
+    const auto downloadsWidget = new QWidget(downloadsDock);
+    downloadsDock->setWidget(downloadsWidget);
+
+    const auto downloadsLayout = new QGridLayout(downloadsWidget);
+    downloadsWidget->setLayout(downloadsLayout);
+
+    downloadsLayout->setRowStretch(0, 1);
+    downloadsLayout->setColumnStretch(0, 1);
+
+    m_downloadsView = new QTableView(downloadsWidget);
+    m_downloadsView->setModel(&m_downloadManager);
+    downloadsLayout->addWidget(m_downloadsView, 0, 0);
+
+    m_downloadsView->setAlternatingRowColors(true);
+    m_downloadsView->setTabKeyNavigation(false);
+    m_downloadsView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_downloadsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    m_downloadsView->verticalHeader()->setVisible(false);
+    m_downloadsView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_downloadsView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    const auto downloadsButtonsWidget = new QWidget(downloadsWidget);
+    downloadsLayout->addWidget(downloadsButtonsWidget, 0, 1);
+    downloadsLayout->setAlignment(downloadsButtonsWidget, Qt::AlignTop);
+
+    const auto downloadsButtonsLayout = new QBoxLayout(QBoxLayout::TopToBottom, downloadsButtonsWidget);
+    downloadsButtonsWidget->setLayout(downloadsButtonsLayout);
+    downloadsButtonsLayout->setSizeConstraint(QLayout::SetFixedSize);
+
+    const auto resumeDownloadsButton = new QPushButton(QIcon::fromTheme(QStringLiteral("media-playback-start")), QString(), downloadsButtonsWidget);
+    resumeDownloadsButton->setToolTip(tr("Resume"));
+    downloadsButtonsLayout->addWidget(resumeDownloadsButton);
+
+    const auto pauseDownloadsButton = new QPushButton(QIcon::fromTheme(QStringLiteral("media-playback-pause")), QString(), downloadsButtonsWidget);
+    pauseDownloadsButton->setToolTip(tr("Pause"));
+    downloadsButtonsLayout->addWidget(pauseDownloadsButton);
+
+    const auto raiseDownloadsButton = new QPushButton(QIcon::fromTheme(QStringLiteral("go-up")), QString(), downloadsButtonsWidget);
+    raiseDownloadsButton->setToolTip(tr("Raise priority"));
+    downloadsButtonsLayout->addWidget(raiseDownloadsButton);
+
+    const auto lowerDownloadsButton = new QPushButton(QIcon::fromTheme(QStringLiteral("go-down")), QString(), downloadsButtonsWidget);
+    lowerDownloadsButton->setToolTip(tr("Lower priority"));
+    downloadsButtonsLayout->addWidget(lowerDownloadsButton);
+
+    const auto removeDownloadsButton = new QPushButton(QIcon::fromTheme(QStringLiteral("edit-delete")), QString(), downloadsButtonsWidget);
+    removeDownloadsButton->setToolTip(tr("Remove"));
+    downloadsButtonsLayout->addWidget(removeDownloadsButton);
+
+    connect(resumeDownloadsButton, &QPushButton::pressed, this, &MainWindow::resumeDownloadsPressed);
+    connect(pauseDownloadsButton, &QPushButton::pressed, this, &MainWindow::pauseDownloadsPressed);
+    connect(raiseDownloadsButton, &QPushButton::pressed, this, &MainWindow::raiseDownloadsPressed);
+    connect(lowerDownloadsButton, &QPushButton::pressed, this, &MainWindow::lowerDownloadsPressed);
+    connect(removeDownloadsButton, &QPushButton::pressed, this, &MainWindow::removeDownloadsPressed);
+
+    connect(&m_downloadManager, &DownloadManager::progressChanged, downloadsDock, [downloadsDock](qint64 bytesReceived, qint64 bytesTotal, qint64 bytesPerSecond)
+    {
+        if (bytesPerSecond <= 0)
+        {
+            downloadsDock->setWindowTitle(tr("Downloads"));
+        }
+        else if (bytesTotal > 0)
+        {
+            downloadsDock->setWindowTitle(tr("Downloads (%1 %, %2 MB/s)").arg(100 * bytesReceived / bytesTotal).arg(bytesPerSecond / 1024.0 / 1024.0, 0, 'f', 1));
+        }
+        else
+        {
+            downloadsDock->setWindowTitle(tr("Downloads (%1 MB/s)").arg(bytesPerSecond / 1024.0 / 1024.0, 0, 'f', 1));
+        }
+    });
+
     const auto quitShortcut = new QShortcut(QKeySequence::Quit, this);
     connect(quitShortcut, &QShortcut::activated, this, &MainWindow::close);
 
+#ifdef QMEDIATHEKVIEW_TRACING
+
+    const auto traceShortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::ALT + Qt::Key_T), this);
+    connect(traceShortcut, &QShortcut::activated, [this]()
+    {
+        const auto fileName = Trace::defaultFileName();
+
+        if (Trace::dump(fileName))
+        {
+            statusBar()->showMessage(tr("Dumped trace to %1.").arg(fileName), messageTimeout);
+        }
+        else
+        {
+            statusBar()->showMessage(tr("Failed to dump trace to %1.").arg(fileName), messageTimeout);
+        }
+    });
+
+#endif // QMEDIATHEKVIEW_TRACING
+
     restoreGeometry(m_settings.mainWindowGeometry());
     restoreState(m_settings.mainWindowState());
 
     setWindowTitle(qApp->applicationName() + QStringLiteral("[*]"));
-    statusBar()->showMessage(tr("Ready"), messageTimeout);
+    statusBar()->showMessage(tr("Opening database..."));
 }
 
 MainWindow::~MainWindow()
@@ -212,6 +401,11 @@ MainWindow::~MainWindow()
     m_settings.setMainWindowState(saveState());
 }
 
+void MainWindow::showOpenedDatabase()
+{
+    statusBar()->showMessage(tr("Ready"), messageTimeout);
+}
+
 void MainWindow::showStartedMirrorsUpdate()
 {
     statusBar()->showMessage(tr("Started mirror list update..."), messageTimeout);
@@ -250,6 +444,12 @@ void MainWindow::resetFilterPressed()
     m_channelBox->clearEditText();
     m_topicBox->clearEditText();
     m_titleEdit->clear();
+
+    m_channelsButton->clearSelection();
+    m_dateBox->setCurrentIndex(0);
+    m_timeBox->setCurrentIndex(0);
+    m_minimumDurationBox->setValue(0);
+    m_maximumDurationBox->setValue(0);
 }
 
 void MainWindow::updateDatabasePressed()
@@ -260,6 +460,8 @@ void MainWindow::updateDatabasePressed()
 void MainWindow::editSettingsPressed()
 {
     SettingsDialog(m_settings, this).exec();
+
+    m_downloadManager.schedule();
 }
 
 void MainWindow::playClicked()
@@ -314,15 +516,82 @@ void MainWindow::downloadLargeTriggered()
     });
 }
 
+void MainWindow::resumeDownloadsPressed()
+{
+    forEachSelectedRow(m_downloadsView, [this](const QModelIndex& index)
+    {
+        m_downloadManager.resume(index);
+    });
+}
+
+void MainWindow::pauseDownloadsPressed()
+{
+    forEachSelectedRow(m_downloadsView, [this](const QModelIndex& index)
+    {
+        m_downloadManager.pause(index);
+    });
+}
+
+void MainWindow::raiseDownloadsPressed()
+{
+    forEachSelectedRow(m_downloadsView, [this](const QModelIndex& index)
+    {
+        m_downloadManager.changePriority(index, 1);
+    });
+}
+
+void MainWindow::lowerDownloadsPressed()
+{
+    forEachSelectedRow(m_downloadsView, [this](const QModelIndex& index)
+    {
+        m_downloadManager.changePriority(index, -1);
+    });
+}
+
+void MainWindow::removeDownloadsPressed()
+{
+    // Removing rows invalidates the plain indexes of the rows below.
+    QList< QPersistentModelIndex > indexes;
+
+    forEachSelectedRow(m_downloadsView, [&indexes](const QModelIndex& index)
+    {
+        indexes.append(index);
+    });
+
+    for (const auto& index : indexes)
+    {
+        m_downloadManager.remove(index);
+    }
+}
+
 void MainWindow::timeout()
 {
     m_searchTimer->stop();
 
-    const auto channel = m_channelBox->currentText();
-    const auto topic = m_topicBox->currentText();
-    const auto title = m_titleEdit->text();
+    Filter filter;
+
+    filter.channel = m_channelBox->currentText();
+    filter.topic = m_topicBox->currentText();
+    filter.title = m_titleEdit->text();
+
+    filter.channels = m_channelsButton->selection();
+
+    const auto days = m_dateBox->currentData().toInt();
+
+    if (days >= 0)
+    {
+        filter.fromDate = QDate::currentDate().addDays(-days);
+    }
+
+    const auto& timeRange = timeRanges[qMax(0, m_timeBox->currentIndex())];
+
+    filter.fromTime = timeRange.from;
+    filter.toTime = timeRange.to;
+
+    filter.minimumDuration = fromMinutes(m_minimumDurationBox->value());
+    filter.maximumDuration = fromMinutes(m_maximumDurationBox->value());
 
-    m_model.filter(channel, topic, title);
+    m_model.filter(filter);
 }
 
 void MainWindow::activated(const QModelIndex& index)
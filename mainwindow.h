@@ -27,6 +27,7 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 class QComboBox;
 class QLabel;
 class QLineEdit;
+class QSpinBox;
 class QTableView;
 class QTextEdit;
 class QTimer;
@@ -36,7 +37,9 @@ namespace QMediathekView
 
 class Settings;
 class Model;
+class DownloadManager;
 class UrlButton;
+class ChannelsButton;
 class Application;
 
 class MainWindow : public QMainWindow
@@ -45,10 +48,12 @@ class MainWindow : public QMainWindow
     Q_DISABLE_COPY(MainWindow)
 
 public:
-    MainWindow(Settings& settings, Model& model, Application& application, QWidget* parent = 0);
+    MainWindow(Settings& settings, Model& model, DownloadManager& downloadManager, Application& application, QWidget* parent = 0);
     ~MainWindow();
 
 public:
+    void showOpenedDatabase();
+
     void showStartedMirrorsUpdate();
     void showCompletedMirrorsUpdate();
     void showMirrorsUpdateFailure(const QString& error);
@@ -72,6 +77,12 @@ private:
     void downloadSmallTriggered();
     void downloadLargeTriggered();
 
+    void resumeDownloadsPressed();
+    void pauseDownloadsPressed();
+    void raiseDownloadsPressed();
+    void lowerDownloadsPressed();
+    void removeDownloadsPressed();
+
     void timeout();
     void activated(const QModelIndex& index);
     void currentChanged(const QModelIndex& current, const QModelIndex& previous);
@@ -79,6 +90,7 @@ private:
 private:
     Settings& m_settings;
     Model& m_model;
+    DownloadManager& m_downloadManager;
     Application& m_application;
 
     QTableView* m_tableView;
@@ -89,12 +101,20 @@ private:
     QComboBox* m_topicBox;
     QLineEdit* m_titleEdit;
 
+    ChannelsButton* m_channelsButton;
+    QComboBox* m_dateBox;
+    QComboBox* m_timeBox;
+    QSpinBox* m_minimumDurationBox;
+    QSpinBox* m_maximumDurationBox;
+
     QTextEdit* m_descriptionEdit;
     QLabel* m_websiteLabel;
 
     UrlButton* m_playButton;
     UrlButton* m_downloadButton;
 
+    QTableView* m_downloadsView;
+
 };
 
 } // QMediathekView
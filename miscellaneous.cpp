@@ -21,7 +21,9 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "miscellaneous.h"
 
+#include <QAbstractItemModel>
 #include <QAction>
+#include <QMenu>
 
 #include "model.h"
 
@@ -53,4 +55,83 @@ void UrlButton::currentChanged(const QModelIndex& current, const QModelIndex& /*
     m_largeAction->setDisabled(m_model.urlLarge(current).isEmpty());
 }
 
+ChannelsButton::ChannelsButton(const QAbstractItemModel* channels, QWidget* parent)
+    : QToolButton(parent)
+    , m_channels(channels)
+    , m_menu(new QMenu(this))
+{
+    setMenu(m_menu);
+    setPopupMode(QToolButton::InstantPopup);
+
+    connect(m_channels, &QAbstractItemModel::modelReset, this, &ChannelsButton::populate);
+
+    populate();
+}
+
+QStringList ChannelsButton::selection() const
+{
+    QStringList selection;
+
+    for (const auto action : m_menu->actions())
+    {
+        if (action->isChecked())
+        {
+            selection.append(action->text());
+        }
+    }
+
+    return selection;
+}
+
+void ChannelsButton::clearSelection()
+{
+    for (const auto action : m_menu->actions())
+    {
+        action->setChecked(false);
+    }
+}
+
+void ChannelsButton::populate()
+{
+    const auto selection = this->selection();
+
+    m_menu->clear();
+
+    for (int row = 0; row < m_channels->rowCount(); ++row)
+    {
+        const auto channel = m_channels->index(row, 0).data().toString();
+
+        if (channel.isEmpty())
+        {
+            continue;
+        }
+
+        const auto action = m_menu->addAction(channel);
+        action->setCheckable(true);
+        action->setChecked(selection.contains(channel));
+
+        connect(action, &QAction::toggled, this, [this]()
+        {
+            showSelection();
+
+            emit selectionChanged();
+        });
+    }
+
+    showSelection();
+
+    // Channels which no longer exist are dropped from the selection.
+    if (this->selection() != selection)
+    {
+        emit selectionChanged();
+    }
+}
+
+void ChannelsButton::showSelection()
+{
+    const auto selection = this->selection();
+
+    setText(selection.isEmpty() ? tr("All channels") : selection.join(QStringLiteral(", ")));
+}
+
 } // QMediathekView
@@ -25,6 +25,8 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #include <QToolButton>
 
 class QAction;
+class QAbstractItemModel;
+class QMenu;
 
 namespace QMediathekView
 {
@@ -56,6 +58,32 @@ private:
 
 };
 
+// Selects any number of channels from the given list, where selecting none means all of them.
+class ChannelsButton : public QToolButton
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ChannelsButton)
+
+public:
+    ChannelsButton(const QAbstractItemModel* channels, QWidget* parent);
+
+signals:
+    void selectionChanged();
+
+public:
+    QStringList selection() const;
+    void clearSelection();
+
+private:
+    const QAbstractItemModel* m_channels;
+
+    QMenu* m_menu;
+
+    void populate();
+    void showSelection();
+
+};
+
 } // QMediathekView
 
 #endif // MISCELLANEOUS_H
@@ -24,11 +24,14 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #include <QStringListModel>
 
 #include "database.h"
+#include "completionmodel.h"
+#include "trace.h"
 
 namespace
 {
 
 constexpr auto cacheSize = 1024;
+constexpr auto detailsCacheSize = 16;
 constexpr auto fetchSize = 256;
 
 } // anonymous
@@ -38,11 +41,18 @@ namespace QMediathekView
 
 Model::Model(Database& database, QObject* parent) : QAbstractTableModel(parent),
     m_database(database),
-    m_cache(cacheSize),
+    m_rows(cacheSize),
+    m_details(detailsCacheSize),
     m_channels(new QStringListModel(this)),
-    m_topics(new QStringListModel(this))
+    m_topics(new QStringListModel(this)),
+    m_channelCompletions(new CompletionModel(this)),
+    m_topicCompletions(new CompletionModel(this))
 {
-    update();
+    // Otherwise the model is filled once the database has been opened in the background.
+    if (m_database.isOpen())
+    {
+        update();
+    }
 }
 
 Model::~Model()
@@ -122,6 +132,8 @@ QModelIndex Model::index(int row, int column, const QModelIndex& parent) const
 
 QVariant Model::data(const QModelIndex& index, int role) const
 {
+    TRACE_SCOPE("Model::data");
+
     if (role != Qt::DisplayRole)
     {
         return {};
@@ -138,41 +150,40 @@ QVariant Model::data(const QModelIndex& index, int role) const
     switch (column)
     {
     case 0:
-        return fetchShow(id, std::mem_fn(&Show::channel));
+        return fetchRow(id, std::mem_fn(&ShowRow::channel));
     case 1:
-        return fetchShow(id, std::mem_fn(&Show::topic));
+        return fetchRow(id, std::mem_fn(&ShowRow::topic));
     case 2:
-        return fetchShow(id, std::mem_fn(&Show::title));
+        return fetchRow(id, std::mem_fn(&ShowRow::title));
     case 3:
-        return fetchShow(id, std::mem_fn(&Show::date)).toString(tr("dd.MM.yy"));
+        return fetchRow(id, std::mem_fn(&ShowRow::date)).toString(tr("dd.MM.yy"));
     case 4:
-        return fetchShow(id, std::mem_fn(&Show::time)).toString(tr("hh:mm"));
+        return fetchRow(id, std::mem_fn(&ShowRow::time)).toString(tr("hh:mm"));
     case 5:
-        return fetchShow(id, std::mem_fn(&Show::duration)).toString(tr("hh:mm:ss"));
+        return fetchRow(id, std::mem_fn(&ShowRow::duration)).toString(tr("hh:mm:ss"));
     default:
         return {};
     }
 }
 
-void Model::filter(const QString& channel, const QString& topic, const QString& title)
+void Model::filter(const Filter& filter)
 {
-    if (m_channel == channel && m_topic == topic && m_title == title)
+    if (m_filter == filter)
     {
         return;
     }
 
     beginResetModel();
 
-    if (m_channel != channel)
-    {
-        m_channel = channel;
+    const auto channelChanged = m_filter.channel != filter.channel;
+
+    m_filter = filter;
 
+    if (channelChanged)
+    {
         fetchTopics();
     }
 
-    m_topic = topic;
-    m_title = title;
-
     query();
 
     endResetModel();
@@ -212,6 +223,8 @@ bool Model::canFetchMore(const QModelIndex& parent) const
 
 void Model::fetchMore(const QModelIndex& parent)
 {
+    TRACE_SCOPE("Model::fetchMore");
+
     if (parent.isValid())
     {
         return;
@@ -236,6 +249,27 @@ QAbstractItemModel* Model::topics() const
     return m_topics;
 }
 
+CompletionModel* Model::channelCompletions() const
+{
+    return m_channelCompletions;
+}
+
+CompletionModel* Model::topicCompletions() const
+{
+    return m_topicCompletions;
+}
+
+QByteArray Model::key(const QModelIndex& index) const
+{
+    if (!index.isValid())
+    {
+        return {};
+    }
+
+    // The key covers the URL which is part of the details and is only needed when starting a download.
+    return keyOf(*m_database.show(index.internalId()));
+}
+
 QString Model::title(const QModelIndex& index) const
 {
     if (!index.isValid())
@@ -243,7 +277,7 @@ QString Model::title(const QModelIndex& index) const
         return {};
     }
 
-    return fetchShow(index.internalId(), std::mem_fn(&Show::title));
+    return fetchRow(index.internalId(), std::mem_fn(&ShowRow::title));
 }
 
 QString Model::description(const QModelIndex& index) const
@@ -253,7 +287,7 @@ QString Model::description(const QModelIndex& index) const
         return {};
     }
 
-    return fetchShow(index.internalId(), std::mem_fn(&Show::description));
+    return fetchDetails(index.internalId(), std::mem_fn(&ShowDetails::description));
 }
 
 QString Model::website(const QModelIndex& index) const
@@ -263,7 +297,7 @@ QString Model::website(const QModelIndex& index) const
         return {};
     }
 
-    return fetchShow(index.internalId(), std::mem_fn(&Show::website));
+    return fetchDetails(index.internalId(), std::mem_fn(&ShowDetails::website));
 }
 
 QString Model::url(const QModelIndex& index) const
@@ -273,7 +307,7 @@ QString Model::url(const QModelIndex& index) const
         return {};
     }
 
-    return fetchShow(index.internalId(), std::mem_fn(&Show::url));
+    return fetchDetails(index.internalId(), std::mem_fn(&ShowDetails::url));
 }
 
 QString Model::urlSmall(const QModelIndex& index) const
@@ -283,7 +317,7 @@ QString Model::urlSmall(const QModelIndex& index) const
         return {};
     }
 
-    return fetchShow(index.internalId(), std::mem_fn(&Show::urlSmall));
+    return fetchDetails(index.internalId(), std::mem_fn(&ShowDetails::urlSmall));
 }
 
 QString Model::urlLarge(const QModelIndex& index) const
@@ -293,11 +327,13 @@ QString Model::urlLarge(const QModelIndex& index) const
         return {};
     }
 
-    return fetchShow(index.internalId(), std::mem_fn(&Show::urlLarge));
+    return fetchDetails(index.internalId(), std::mem_fn(&ShowDetails::urlLarge));
 }
 
 void Model::update()
 {
+    TRACE_SCOPE("Model::update");
+
     beginResetModel();
 
     query();
@@ -309,6 +345,8 @@ void Model::update()
 
 void Model::query()
 {
+    TRACE_SCOPE("Model::query");
+
     Database::SortColumn sortColumn;
 
     switch (m_sortColumn)
@@ -334,25 +372,44 @@ void Model::query()
         break;
     }
 
-    m_id = m_database.query(
-               m_channel, m_topic, m_title,
-               sortColumn, m_sortOrder);
+    m_id = m_database.query(m_filter, sortColumn, m_sortOrder);
     m_fetched = 0;
 }
 
 template< typename Member >
-Model::ResultOf< Member > Model::fetchShow(const quintptr id, Member member) const
+Model::ResultOf< Member, ShowRow > Model::fetchRow(const quintptr id, Member member) const
+{
+    TRACE_SCOPE("Model::fetchRow");
+
+    if (const auto row = m_rows.object(id))
+    {
+        return member(*row);
+    }
+
+    auto row = m_database.showRow(id);
+
+    const auto value = member(*row);
+
+    m_rows.insert(id, row.release());
+
+    return value;
+}
+
+template< typename Member >
+Model::ResultOf< Member, ShowDetails > Model::fetchDetails(const quintptr id, Member member) const
 {
-    if (const auto show = m_cache.object(id))
+    TRACE_SCOPE("Model::fetchDetails");
+
+    if (const auto details = m_details.object(id))
     {
-        return member(*show);
+        return member(*details);
     }
 
-    auto show = m_database.show(id);
+    auto details = m_database.showDetails(id);
 
-    const auto value = member(*show);
+    const auto value = member(*details);
 
-    m_cache.insert(id, show.release());
+    m_details.insert(id, details.release());
 
     return value;
 }
@@ -360,6 +417,9 @@ Model::ResultOf< Member > Model::fetchShow(const quintptr id, Member member) con
 void Model::fetchChannels()
 {
     auto channels = m_database.channels();
+
+    m_channelCompletions->setEntries(channels, m_database.channelCounts());
+
     channels.prepend(QString());
 
     if (m_channels->stringList() != channels)
@@ -370,7 +430,10 @@ void Model::fetchChannels()
 
 void Model::fetchTopics()
 {
-    auto topics = m_database.topics(m_channel);
+    auto topics = m_database.topics(m_filter.channel);
+
+    m_topicCompletions->setEntries(topics, m_database.topicCounts(m_filter.channel));
+
     topics.prepend(QString());
 
     if (m_topics->stringList() != topics)
@@ -28,11 +28,12 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 class QStringListModel;
 
 #include "schema.h"
+#include "database.h"
 
 namespace QMediathekView
 {
 
-class Database;
+class CompletionModel;
 
 class Model : public QAbstractTableModel
 {
@@ -51,7 +52,7 @@ public:
     QModelIndex index(int row, int column, const QModelIndex& parent) const override;
     QVariant data(const QModelIndex& index, int role) const override;
 
-    void filter(const QString& channel, const QString& topic, const QString& title);
+    void filter(const Filter& filter);
     void sort(int column, Qt::SortOrder order) override;
 
 protected:
@@ -62,7 +63,12 @@ public:
     QAbstractItemModel* channels() const;
     QAbstractItemModel* topics() const;
 
+    CompletionModel* channelCompletions() const;
+    CompletionModel* topicCompletions() const;
+
 public:
+    QByteArray key(const QModelIndex& index) const;
+
     QString title(const QModelIndex& index) const;
 
     QString description(const QModelIndex& index) const;
@@ -78,9 +84,7 @@ public:
 private:
     const Database& m_database;
 
-    QString m_channel;
-    QString m_topic;
-    QString m_title;
+    Filter m_filter;
 
     int m_sortColumn = 0;
     Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
@@ -90,17 +94,25 @@ private:
 
     void query();
 
-    mutable QCache< quintptr, Show > m_cache;
+    // Rows are cached for scrolling whereas details are only fetched for the few selected shows.
+    mutable QCache< quintptr, ShowRow > m_rows;
+    mutable QCache< quintptr, ShowDetails > m_details;
+
+    template< typename Member, typename Record >
+    using ResultOf = typename std::decay< typename std::result_of< Member(Record) >::type >::type;
 
     template< typename Member >
-    using ResultOf = typename std::decay< typename std::result_of< Member(Show) >::type >::type;
+    ResultOf< Member, ShowRow > fetchRow(const quintptr id, Member member) const;
 
     template< typename Member >
-    ResultOf< Member > fetchShow(const quintptr id, Member member) const;
+    ResultOf< Member, ShowDetails > fetchDetails(const quintptr id, Member member) const;
 
     QStringListModel* m_channels;
     QStringListModel* m_topics;
 
+    CompletionModel* m_channelCompletions;
+    CompletionModel* m_topicCompletions;
+
     void fetchChannels();
     void fetchTopics();
 
@@ -23,6 +23,8 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <boost/spirit/include/qi.hpp>
 
+#include "trace.h"
+
 namespace QMediathekView
 {
 
@@ -31,31 +33,80 @@ namespace
 
 // *INDENT-OFF*
 
+constexpr std::size_t batchSize = 1024;
+
 template< typename Iterator, typename Skipper >
 struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
 {
-    Show show;
+    typedef boost::iterator_range< Iterator > Range;
+
+    ShowRecord show;
     Processor& processor;
 
-    void setChannel(const std::string& channel)
+    Arena arena;
+    std::vector< ShowRecord > batch;
+
+    std::string lastChannel;
+    std::string lastTopic;
+
+    Text unescape(const Range& text)
+    {
+        const auto data = arena.allocate(text.size());
+        auto end = data;
+
+        for (auto position = text.begin(); position != text.end(); ++position)
+        {
+            auto character = *position;
+
+            if (character == '\\')
+            {
+                switch (character = *++position)
+                {
+                case 'b':
+                    character = '\b';
+                    break;
+                case 'f':
+                    character = '\f';
+                    break;
+                case 'n':
+                    character = '\n';
+                    break;
+                case 'r':
+                    character = '\r';
+                    break;
+                case 't':
+                    character = '\t';
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            *end++ = character;
+        }
+
+        return { data, int(end - data) };
+    }
+
+    void setChannel(const Range& channel)
     {
         if (!channel.empty())
         {
-            show.channel = QString::fromStdString(channel);
+            show.channel = unescape(channel);
         }
     }
 
-    void setTopic(const std::string& topic)
+    void setTopic(const Range& topic)
     {
         if (!topic.empty())
         {
-            show.topic = QString::fromStdString(topic);
+            show.topic = unescape(topic);
         }
     }
 
-    void setTitle(const std::string& title)
+    void setTitle(const Range& title)
     {
-        show.title = QString::fromStdString(title);
+        show.title = unescape(title);
     }
 
     void setDate(const boost::fusion::vector< int, int, int >& date)
@@ -106,22 +157,22 @@ struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
         show.duration = {};
     }
 
-    void setDescription(const std::string& description)
+    void setDescription(const Range& description)
     {
-        show.description = QString::fromStdString(description);
+        show.description = unescape(description);
     }
 
-    void setWebsite(const std::string& website)
+    void setWebsite(const Range& website)
     {
-        show.website = QString::fromStdString(website);
+        show.website = unescape(website);
     }
 
-    void setUrl(const std::string& url)
+    void setUrl(const Range& url)
     {
-        show.url = QString::fromStdString(url);
+        show.url = unescape(url);
     }
 
-    void setUrlSmall(const boost::fusion::vector< int, std::string >& replacement)
+    void setUrlSmall(const boost::fusion::vector< int, Range >& replacement)
     {
         using boost::fusion::at_c;
 
@@ -129,16 +180,16 @@ struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
         const auto& suffix = at_c<1>(replacement);
 
         show.urlSmallOffset = offset;
-        show.urlSmallSuffix = QString::fromStdString(suffix);
+        show.urlSmallSuffix = unescape(suffix);
     }
 
     void resetUrlSmall()
     {
         show.urlSmallOffset = 0;
-        show.urlSmallSuffix.clear();
+        show.urlSmallSuffix = {};
     }
 
-    void setUrlLarge(const boost::fusion::vector< int, std::string >& replacement)
+    void setUrlLarge(const boost::fusion::vector< int, Range >& replacement)
     {
         using boost::fusion::at_c;
 
@@ -146,18 +197,44 @@ struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
         const auto& suffix = at_c<1>(replacement);
 
         show.urlLargeOffset = offset;
-        show.urlLargeSuffix = QString::fromStdString(suffix);
+        show.urlLargeSuffix = unescape(suffix);
     }
 
     void resetUrlLarge()
     {
         show.urlLargeOffset = 0;
-        show.urlLargeSuffix.clear();
+        show.urlLargeSuffix = {};
     }
 
     void processEntry()
     {
-        processor(show);
+        batch.push_back(show);
+
+        if (batch.size() == batchSize)
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        TRACE_SCOPE("parse/flush");
+
+        if (!batch.empty())
+        {
+            processor(batch);
+            batch.clear();
+        }
+
+        // Channel and topic are inherited by the following entries if left empty,
+        // hence they need to survive resetting the arena.
+        lastChannel.assign(show.channel.data, show.channel.size);
+        lastTopic.assign(show.topic.data, show.topic.size);
+
+        arena.reset();
+
+        show.channel = arena.copy(lastChannel.data(), lastChannel.size());
+        show.topic = arena.copy(lastTopic.data(), lastTopic.size());
     }
 
     template< typename Attributes >
@@ -176,12 +253,12 @@ struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
 
     Rule< void() > ignoredItem;
     Rule< void() > emptyItem;
-    Rule< std::string() > textItem;
-    Rule< boost::fusion::vector< int, std::string >() > textReplacementItem;
+    Rule< Range() > textItem;
+    Rule< boost::fusion::vector< int, Range >() > textReplacementItem;
     Rule< boost::fusion::vector< int, int, int >() > dateItem;
     Rule< boost::fusion::vector< int, int, int >() > timeItem;
 
-    boost::spirit::qi::rule< Iterator, std::string() > escapedText;
+    boost::spirit::qi::rule< Iterator > escapedText;
 
     Grammar(Processor& inserter)
         : Grammar::base_type(start)
@@ -190,39 +267,34 @@ struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
         using std::bind;
         using std::placeholders::_1;
 
-        using boost::spirit::qi::attr;
         using boost::spirit::qi::char_;
         using boost::spirit::qi::int_;
         using boost::spirit::qi::eps;
         using boost::spirit::qi::lexeme;
         using boost::spirit::qi::lit;
+        using boost::spirit::qi::raw;
+
+        batch.reserve(batchSize);
 
-        escapedText %= *(~char_("\\\"")
-                         | (lit("\\\\") >> attr('\\'))
-                         | (lit("\\\"") >> attr('"'))
-                         | (lit("\\b") >> attr('\b'))
-                         | (lit("\\f") >> attr('\f'))
-                         | (lit("\\n") >> attr('\n'))
-                         | (lit("\\r") >> attr('\r'))
-                         | (lit("\\t") >> attr('\t')));
+        escapedText = *(~char_("\\\"") | (lit('\\') >> char_("\\\"bfnrt")));
 
         ignoredItem %= lexeme[eps
                 >> lit('"')
-                >> *(~char_("\\\"") | (lit('\\') >> char_("\\\"bfnrt")))
+                >> escapedText
                 >> lit('"')];
 
         emptyItem %= lit("\"\"");
 
         textItem %= lexeme[eps
                 >> lit('"')
-                >> escapedText
+                >> raw[escapedText]
                 >> lit('"')];
 
         textReplacementItem %= lexeme[eps
                 >> lit('"')
                 >> int_
                 >> lit('|')
-                >> escapedText
+                >> raw[escapedText]
                 >> lit('"')];
 
         dateItem %= eps
@@ -292,9 +364,18 @@ struct Grammar : boost::spirit::qi::grammar< Iterator, void(), Skipper >
 
 bool parse(const QByteArray& data, Processor& processor)
 {
+    TRACE_SCOPE("parse");
+
     Grammar< QByteArray::const_iterator, boost::spirit::ascii::space_type > grammar(processor);
 
-    return boost::spirit::qi::phrase_parse(data.begin(), data.end(), grammar, boost::spirit::ascii::space);
+    if (!boost::spirit::qi::phrase_parse(data.begin(), data.end(), grammar, boost::spirit::ascii::space))
+    {
+        return false;
+    }
+
+    grammar.flush();
+
+    return true;
 }
 
 } // QMediathekView
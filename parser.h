@@ -22,14 +22,42 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <vector>
+
 #include "schema.h"
+#include "arena.h"
 
 namespace QMediathekView
 {
 
+struct ShowRecord
+{
+    Text channel;
+    Text topic;
+    Text title;
+
+    QDate date;
+    QTime time;
+
+    QTime duration;
+
+    Text description;
+    Text website;
+
+    Text url;
+
+    unsigned short urlSmallOffset = 0;
+    Text urlSmallSuffix;
+
+    unsigned short urlLargeOffset = 0;
+    Text urlLargeSuffix;
+
+};
+
 struct Processor
 {
-    virtual void operator()(const Show& show) = 0;
+    // The text of the given shows is backed by an arena which is reset as soon as this returns.
+    virtual void operator()(const std::vector< ShowRecord >& shows) = 0;
 };
 
 bool parse(const QByteArray& data, Processor& processor);
@@ -27,7 +27,8 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 namespace QMediathekView
 {
 
-struct Show
+// The columns shown in the list of shows which are fetched for every visible row.
+struct ShowRow
 {
     QString channel;
     QString topic;
@@ -38,6 +39,11 @@ struct Show
 
     QTime duration;
 
+};
+
+// The remaining columns which are only fetched for a selected show.
+struct ShowDetails
+{
     QString description;
     QString website;
 
@@ -61,6 +67,10 @@ struct Show
 
 };
 
+struct Show : ShowRow, ShowDetails
+{
+};
+
 enum class Url : int
 {
     Default,
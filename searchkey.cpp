@@ -0,0 +1,82 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "searchkey.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr ushort sharpS = 0x00DF;
+
+bool isAscii(const QString& text)
+{
+    for (const auto character : text)
+    {
+        if (character.unicode() >= 0x80)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // anonymous
+
+QString searchKeyOf(const QString& text)
+{
+    if (isAscii(text))
+    {
+        return text.toLower();
+    }
+
+    // The compatibility decomposition separates diacritics from their base characters, e.g. "Ä" into "A" and "¨".
+    const auto decomposed = text.normalized(QString::NormalizationForm_KD);
+
+    QString key;
+    key.reserve(decomposed.size());
+
+    for (const auto character : decomposed)
+    {
+        if (character.category() == QChar::Mark_NonSpacing)
+        {
+            continue;
+        }
+
+        const auto folded = character.toCaseFolded();
+
+        if (folded.unicode() == sharpS)
+        {
+            key.append(QLatin1String("ss"));
+            continue;
+        }
+
+        key.append(folded);
+    }
+
+    return key;
+}
+
+} // QMediathekView
@@ -0,0 +1,36 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef SEARCHKEY_H
+#define SEARCHKEY_H
+
+#include <QString>
+
+namespace QMediathekView
+{
+
+// Folds case and diacritics so that e.g. "Ärzte", "ärzte" and "ARZTE" or "Straße" and "STRASSE" yield the same key.
+QString searchKeyOf(const QString& text);
+
+} // QMediathekView
+
+#endif // SEARCHKEY_H
@@ -0,0 +1,572 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "server.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include "database.h"
+#include "trace.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto maximumHeaderSize = 16 * 1024;
+constexpr auto maximumBodySize = 1024 * 1024;
+
+constexpr auto idleTimeout = 30 * 1000;
+
+constexpr auto defaultLimit = 50;
+constexpr auto maximumLimit = 1000;
+constexpr auto maximumBatchSize = 100;
+
+const char* const sortColumnNames[] =
+{
+    "channel", "topic", "title", "date", "time", "duration"
+};
+
+namespace Keys
+{
+
+const auto id = QStringLiteral("id");
+const auto channel = QStringLiteral("channel");
+const auto topic = QStringLiteral("topic");
+const auto title = QStringLiteral("title");
+const auto date = QStringLiteral("date");
+const auto time = QStringLiteral("time");
+const auto duration = QStringLiteral("duration");
+const auto description = QStringLiteral("description");
+const auto website = QStringLiteral("website");
+const auto url = QStringLiteral("url");
+const auto urlSmall = QStringLiteral("urlSmall");
+const auto urlLarge = QStringLiteral("urlLarge");
+const auto channels = QStringLiteral("channels");
+const auto fromDate = QStringLiteral("fromDate");
+const auto toDate = QStringLiteral("toDate");
+const auto fromTime = QStringLiteral("fromTime");
+const auto toTime = QStringLiteral("toTime");
+const auto minimumDuration = QStringLiteral("minimumDuration");
+const auto maximumDuration = QStringLiteral("maximumDuration");
+const auto sort = QStringLiteral("sort");
+const auto order = QStringLiteral("order");
+const auto offset = QStringLiteral("offset");
+const auto limit = QStringLiteral("limit");
+const auto total = QStringLiteral("total");
+const auto shows = QStringLiteral("shows");
+const auto status = QStringLiteral("status");
+const auto body = QStringLiteral("body");
+const auto error = QStringLiteral("error");
+
+} // Keys
+
+struct Request
+{
+    QByteArray method;
+    QByteArray target;
+    QByteArray body;
+    bool keepAlive;
+};
+
+enum class Parse
+{
+    Incomplete,
+    Complete,
+    Malformed
+};
+
+Parse parseRequest(QByteArray& buffer, Request& request)
+{
+    const auto headerEnd = buffer.indexOf("\r\n\r\n");
+
+    if (headerEnd < 0)
+    {
+        return buffer.size() > maximumHeaderSize ? Parse::Malformed : Parse::Incomplete;
+    }
+
+    const auto lines = buffer.left(headerEnd).split('\n');
+    const auto requestLine = lines.first().trimmed().split(' ');
+
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/1."))
+    {
+        return Parse::Malformed;
+    }
+
+    qint64 contentLength = 0;
+    QByteArray connection;
+
+    for (int index = 1; index < lines.size(); ++index)
+    {
+        const auto& line = lines.at(index);
+        const auto colon = line.indexOf(':');
+
+        if (colon <= 0)
+        {
+            return Parse::Malformed;
+        }
+
+        const auto name = line.left(colon).trimmed().toLower();
+        const auto value = line.mid(colon + 1).trimmed();
+
+        if (name == "content-length")
+        {
+            bool ok = false;
+            contentLength = value.toLongLong(&ok);
+
+            if (!ok || contentLength < 0 || contentLength > maximumBodySize)
+            {
+                return Parse::Malformed;
+            }
+        }
+        else if (name == "connection")
+        {
+            connection = value.toLower();
+        }
+    }
+
+    const auto bodyBegin = headerEnd + 4;
+
+    if (buffer.size() < bodyBegin + contentLength)
+    {
+        return Parse::Incomplete;
+    }
+
+    request.method = requestLine.at(0);
+    request.target = requestLine.at(1);
+    request.body = buffer.mid(bodyBegin, contentLength);
+
+    // Connections are persistent by default since HTTP/1.1.
+    request.keepAlive = requestLine.at(2) == "HTTP/1.1" ? connection != "close" : connection == "keep-alive";
+
+    buffer.remove(0, bodyBegin + contentLength);
+
+    return Parse::Complete;
+}
+
+QByteArray reasonOf(const int status)
+{
+    switch (status)
+    {
+    case 200:
+        return "OK";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    default:
+        return "Internal Server Error";
+    }
+}
+
+QByteArray toJson(const QJsonValue& value)
+{
+    if (value.isArray())
+    {
+        return QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+    }
+
+    return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+}
+
+// Parses the ranges and channels of the filter, all of which are optional.
+bool parseFilter(const QUrlQuery& query, Filter& filter)
+{
+    if (query.hasQueryItem(Keys::channels))
+    {
+        filter.channels = query.queryItemValue(Keys::channels, QUrl::FullyDecoded).split(QChar(','), QString::SkipEmptyParts);
+    }
+
+    const auto parseDate = [&query](const QString& key, QDate& date)
+    {
+        if (!query.hasQueryItem(key))
+        {
+            return true;
+        }
+
+        date = QDate::fromString(query.queryItemValue(key), Qt::ISODate);
+
+        return date.isValid();
+    };
+
+    const auto parseTime = [&query](const QString& key, QTime& time)
+    {
+        if (!query.hasQueryItem(key))
+        {
+            return true;
+        }
+
+        time = QTime::fromString(query.queryItemValue(key), Qt::ISODate);
+
+        return time.isValid();
+    };
+
+    return parseDate(Keys::fromDate, filter.fromDate) && parseDate(Keys::toDate, filter.toDate)
+           && parseTime(Keys::fromTime, filter.fromTime) && parseTime(Keys::toTime, filter.toTime)
+           && parseTime(Keys::minimumDuration, filter.minimumDuration) && parseTime(Keys::maximumDuration, filter.maximumDuration);
+}
+
+QJsonObject errorObject(const QString& message)
+{
+    QJsonObject object;
+    object.insert(Keys::error, message);
+
+    return object;
+}
+
+} // anonymous
+
+Server::Server(const Database& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &Server::accept);
+}
+
+Server::~Server()
+{
+}
+
+bool Server::listen(const quint16 port)
+{
+    return m_server->listen(QHostAddress::LocalHost, port);
+}
+
+QString Server::errorString() const
+{
+    return m_server->errorString();
+}
+
+Server::Response Server::handle(const QByteArray& method, const QUrl& url, const QByteArray& body)
+{
+    TRACE_SCOPE("Server::handle");
+
+    const auto path = url.path();
+    const QUrlQuery query(url);
+
+    if (path == QLatin1String("/batch"))
+    {
+        if (method != "POST")
+        {
+            return { 405, toJson(errorObject(tr("Batches must be posted."))) };
+        }
+
+        return batch(body);
+    }
+
+    if (method != "GET")
+    {
+        return { 405, toJson(errorObject(tr("Only GET requests are supported."))) };
+    }
+
+    if (path == QLatin1String("/search"))
+    {
+        return search(query);
+    }
+    else if (path == QLatin1String("/show"))
+    {
+        return show(query);
+    }
+    else if (path == QLatin1String("/channels"))
+    {
+        return channels();
+    }
+    else if (path == QLatin1String("/topics"))
+    {
+        return topics(query);
+    }
+
+    return { 404, toJson(errorObject(tr("Unknown resource."))) };
+}
+
+Server::Response Server::search(const QUrlQuery& query) const
+{
+    Filter filter;
+
+    filter.channel = query.queryItemValue(Keys::channel, QUrl::FullyDecoded);
+    filter.topic = query.queryItemValue(Keys::topic, QUrl::FullyDecoded);
+    filter.title = query.queryItemValue(Keys::title, QUrl::FullyDecoded);
+
+    if (!parseFilter(query, filter))
+    {
+        return { 400, toJson(errorObject(tr("Invalid date, time or duration."))) };
+    }
+
+    const auto sortValue = query.hasQueryItem(Keys::sort) ? query.queryItemValue(Keys::sort).toLatin1() : QByteArray("channel");
+    const auto sortColumn = std::find_if(std::begin(sortColumnNames), std::end(sortColumnNames), [&](const char* name)
+    {
+        return sortValue == name;
+    });
+
+    if (sortColumn == std::end(sortColumnNames))
+    {
+        return { 400, toJson(errorObject(tr("Unknown sort column."))) };
+    }
+
+    const auto descending = query.queryItemValue(Keys::order) == QLatin1String("descending");
+
+    bool ok = true;
+
+    const auto offset = query.hasQueryItem(Keys::offset) ? query.queryItemValue(Keys::offset).toInt(&ok) : 0;
+
+    if (!ok || offset < 0)
+    {
+        return { 400, toJson(errorObject(tr("Invalid offset."))) };
+    }
+
+    const auto limit = query.hasQueryItem(Keys::limit) ? query.queryItemValue(Keys::limit).toInt(&ok) : defaultLimit;
+
+    if (!ok || limit < 0 || limit > maximumLimit)
+    {
+        return { 400, toJson(errorObject(tr("Invalid limit."))) };
+    }
+
+    // Paging through the results is served from the database's query cache.
+    const auto ids = m_database.query(
+                         filter,
+                         Database::SortColumn(sortColumn - std::begin(sortColumnNames)),
+                         descending ? Qt::DescendingOrder : Qt::AscendingOrder);
+
+    QJsonArray shows;
+
+    const auto end = int(qMin(qint64(ids.size()), qint64(offset) + limit));
+
+    for (auto index = offset; index < end; ++index)
+    {
+        const auto id = ids.at(index);
+        // Only the list columns are emitted, so neither descriptions nor URLs are read.
+        const auto show = m_database.showRow(id);
+
+        QJsonObject object;
+
+        object.insert(Keys::id, double(id));
+        object.insert(Keys::channel, show->channel);
+        object.insert(Keys::topic, show->topic);
+        object.insert(Keys::title, show->title);
+        object.insert(Keys::date, show->date.toString(Qt::ISODate));
+        object.insert(Keys::time, show->time.toString(Qt::ISODate));
+        object.insert(Keys::duration, show->duration.toString(Qt::ISODate));
+
+        shows.append(object);
+    }
+
+    QJsonObject result;
+
+    result.insert(Keys::total, ids.size());
+    result.insert(Keys::offset, offset);
+    result.insert(Keys::shows, shows);
+
+    return { 200, toJson(result) };
+}
+
+Server::Response Server::show(const QUrlQuery& query) const
+{
+    bool ok = false;
+    const auto id = query.queryItemValue(Keys::id).toULongLong(&ok);
+
+    if (!ok)
+    {
+        return { 400, toJson(errorObject(tr("Invalid identifier."))) };
+    }
+
+    const auto show = m_database.show(id);
+
+    if (show->title.isEmpty() && show->url.isEmpty())
+    {
+        return { 404, toJson(errorObject(tr("Unknown show."))) };
+    }
+
+    QJsonObject object;
+
+    object.insert(Keys::id, double(id));
+    object.insert(Keys::channel, show->channel);
+    object.insert(Keys::topic, show->topic);
+    object.insert(Keys::title, show->title);
+    object.insert(Keys::date, show->date.toString(Qt::ISODate));
+    object.insert(Keys::time, show->time.toString(Qt::ISODate));
+    object.insert(Keys::duration, show->duration.toString(Qt::ISODate));
+    object.insert(Keys::description, show->description);
+    object.insert(Keys::website, show->website);
+    object.insert(Keys::url, show->url);
+    object.insert(Keys::urlSmall, show->urlSmall());
+    object.insert(Keys::urlLarge, show->urlLarge());
+
+    return { 200, toJson(object) };
+}
+
+Server::Response Server::channels() const
+{
+    return { 200, toJson(QJsonArray::fromStringList(m_database.channels())) };
+}
+
+Server::Response Server::topics(const QUrlQuery& query) const
+{
+    const auto channel = query.queryItemValue(Keys::channel, QUrl::FullyDecoded);
+
+    return { 200, toJson(QJsonArray::fromStringList(m_database.topics(channel))) };
+}
+
+Server::Response Server::batch(const QByteArray& body)
+{
+    const auto document = QJsonDocument::fromJson(body);
+
+    if (!document.isArray() || document.array().size() > maximumBatchSize)
+    {
+        return { 400, toJson(errorObject(tr("Expected an array of at most %1 request targets.").arg(maximumBatchSize))) };
+    }
+
+    QJsonArray responses;
+
+    for (const auto& target : document.array())
+    {
+        const auto url = QUrl(target.toString());
+
+        auto response = Response { 400, toJson(errorObject(tr("Invalid request target."))) };
+
+        if (url.isValid() && url.path() != QLatin1String("/batch"))
+        {
+            response = handle("GET", url, QByteArray());
+        }
+
+        const auto content = QJsonDocument::fromJson(response.body);
+
+        QJsonObject object;
+
+        object.insert(Keys::status, response.status);
+        object.insert(Keys::body, content.isArray() ? QJsonValue(content.array()) : QJsonValue(content.object()));
+
+        responses.append(object);
+    }
+
+    return { 200, toJson(responses) };
+}
+
+void Server::accept()
+{
+    while (const auto socket = m_server->nextPendingConnection())
+    {
+        const auto idleTimer = new QTimer(socket);
+        idleTimer->setSingleShot(true);
+        idleTimer->setInterval(idleTimeout);
+
+        m_connections.insert(socket, { QByteArray(), idleTimer });
+
+        connect(idleTimer, &QTimer::timeout, this, [this, socket]()
+        {
+            close(socket);
+        });
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]()
+        {
+            read(socket);
+        });
+
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]()
+        {
+            close(socket);
+        });
+
+        idleTimer->start();
+    }
+}
+
+void Server::read(QTcpSocket* socket)
+{
+    const auto connection = m_connections.find(socket);
+
+    if (connection == m_connections.end())
+    {
+        return;
+    }
+
+    connection->buffer.append(socket->readAll());
+    connection->idleTimer->start();
+
+    // Pipelined requests are answered in the order they were received.
+    for (;;)
+    {
+        Request request;
+
+        const auto parse = parseRequest(connection->buffer, request);
+
+        if (parse == Parse::Incomplete)
+        {
+            return;
+        }
+
+        auto response = Response { 400, toJson(errorObject(tr("Malformed request."))) };
+
+        if (parse == Parse::Complete)
+        {
+            response = handle(request.method, QUrl(QString::fromUtf8(request.target)), request.body);
+        }
+        else
+        {
+            request.keepAlive = false;
+        }
+
+        QByteArray header;
+
+        header.append("HTTP/1.1 ").append(QByteArray::number(response.status)).append(' ').append(reasonOf(response.status)).append("\r\n");
+        header.append("Content-Type: application/json\r\n");
+        header.append("Content-Length: ").append(QByteArray::number(response.body.size())).append("\r\n");
+        header.append(request.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+        header.append("\r\n");
+
+        socket->write(header);
+        socket->write(response.body);
+
+        if (!request.keepAlive)
+        {
+            socket->disconnectFromHost();
+            return;
+        }
+    }
+}
+
+void Server::close(QTcpSocket* socket)
+{
+    if (m_connections.remove(socket) == 0)
+    {
+        return;
+    }
+
+    disconnect(socket, nullptr, this, nullptr);
+
+    socket->disconnectFromHost();
+    socket->deleteLater();
+}
+
+} // QMediathekView
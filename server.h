@@ -0,0 +1,90 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+class QUrl;
+class QUrlQuery;
+
+namespace QMediathekView
+{
+
+class Database;
+
+// Answers search requests of other local tools via HTTP using JSON documents.
+class Server : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Server)
+
+public:
+    explicit Server(const Database& database, QObject* parent = 0);
+    ~Server();
+
+    // Only binds to the loopback interface as there is no authentication.
+    bool listen(const quint16 port);
+    QString errorString() const;
+
+private:
+    struct Response
+    {
+        int status;
+        QByteArray body;
+    };
+
+    Response handle(const QByteArray& method, const QUrl& url, const QByteArray& body);
+
+    Response search(const QUrlQuery& query) const;
+    Response show(const QUrlQuery& query) const;
+    Response channels() const;
+    Response topics(const QUrlQuery& query) const;
+    Response batch(const QByteArray& body);
+
+    void accept();
+    void read(QTcpSocket* socket);
+    void close(QTcpSocket* socket);
+
+private:
+    const Database& m_database;
+
+    QTcpServer* m_server;
+
+    struct Connection
+    {
+        QByteArray buffer;
+        QTimer* idleTimer;
+    };
+
+    QHash< QTcpSocket*, Connection > m_connections;
+
+};
+
+} // QMediathekView
+
+#endif // SERVER_H
@@ -52,9 +52,23 @@ DEFINE_KEY(playCommand);
 DEFINE_KEY(downloadCommand);
 
 DEFINE_KEY(downloadFolder);
+DEFINE_KEY(downloadSegments);
+
+DEFINE_KEY(maximumDownloads);
+DEFINE_KEY(maximumDownloadsPerHost);
+DEFINE_KEY(bandwidthLimit);
+DEFINE_KEY(computeChecksums);
 
 DEFINE_KEY(preferredUrl);
 
+DEFINE_KEY(inMemoryCatalogue);
+DEFINE_KEY(queryCacheSize);
+DEFINE_KEY(compressedStorage);
+
+DEFINE_KEY(serverPort);
+
+DEFINE_KEY(updateLogFile);
+
 DEFINE_KEY(mainWindowGeometry);
 DEFINE_KEY(mainWindowState);
 
@@ -76,9 +90,22 @@ constexpr auto databaseUpdateAfterHours = 3;
 const auto playCommand = QStringLiteral("vlc %1");
 
 const auto downloadFolder = QDir::homePath();
+constexpr auto downloadSegments = 4;
+
+constexpr auto maximumDownloads = 3;
+constexpr auto maximumDownloadsPerHost = 2;
+constexpr auto bandwidthLimit = 0;
+constexpr auto computeChecksums = false;
 
 constexpr auto preferredUrl = Url::Default;
 
+constexpr auto inMemoryCatalogue = true;
+constexpr auto queryCacheSize = 16;
+constexpr auto maximumQueryCacheSize = 1024;
+constexpr auto compressedStorage = false;
+
+constexpr auto serverPort = 0;
+
 } // Defaults
 
 } // anonymous
@@ -197,6 +224,56 @@ void Settings::setDownloadFolder(const QDir& folder)
     m_settings->setValue(Keys::downloadFolder, folder.absolutePath());
 }
 
+int Settings::downloadSegments() const
+{
+    return m_settings->value(Keys::downloadSegments, Defaults::downloadSegments).toInt();
+}
+
+void Settings::setDownloadSegments(int segments)
+{
+    m_settings->setValue(Keys::downloadSegments, segments);
+}
+
+int Settings::maximumDownloads() const
+{
+    return m_settings->value(Keys::maximumDownloads, Defaults::maximumDownloads).toInt();
+}
+
+void Settings::setMaximumDownloads(int downloads)
+{
+    m_settings->setValue(Keys::maximumDownloads, downloads);
+}
+
+int Settings::maximumDownloadsPerHost() const
+{
+    return m_settings->value(Keys::maximumDownloadsPerHost, Defaults::maximumDownloadsPerHost).toInt();
+}
+
+void Settings::setMaximumDownloadsPerHost(int downloads)
+{
+    m_settings->setValue(Keys::maximumDownloadsPerHost, downloads);
+}
+
+int Settings::bandwidthLimit() const
+{
+    return m_settings->value(Keys::bandwidthLimit, Defaults::bandwidthLimit).toInt();
+}
+
+void Settings::setBandwidthLimit(int kibibytesPerSecond)
+{
+    m_settings->setValue(Keys::bandwidthLimit, kibibytesPerSecond);
+}
+
+bool Settings::computeChecksums() const
+{
+    return m_settings->value(Keys::computeChecksums, Defaults::computeChecksums).toBool();
+}
+
+void Settings::setComputeChecksums(bool enabled)
+{
+    m_settings->setValue(Keys::computeChecksums, enabled);
+}
+
 Url Settings::preferredUrl() const
 {
     return Url(m_settings->value(Keys::preferredUrl, int(Defaults::preferredUrl)).toInt());
@@ -207,6 +284,57 @@ void Settings::setPreferredUrl(const Url type)
     m_settings->setValue(Keys::preferredUrl, int(type));
 }
 
+bool Settings::inMemoryCatalogue() const
+{
+    return m_settings->value(Keys::inMemoryCatalogue, Defaults::inMemoryCatalogue).toBool();
+}
+
+void Settings::setInMemoryCatalogue(bool enabled)
+{
+    m_settings->setValue(Keys::inMemoryCatalogue, enabled);
+}
+
+int Settings::queryCacheSize() const
+{
+    // A hand-edited value must not overflow the budget in bytes.
+    return qBound(0, m_settings->value(Keys::queryCacheSize, Defaults::queryCacheSize).toInt(), Defaults::maximumQueryCacheSize);
+}
+
+void Settings::setQueryCacheSize(int mebibytes)
+{
+    m_settings->setValue(Keys::queryCacheSize, mebibytes);
+}
+
+bool Settings::compressedStorage() const
+{
+    return m_settings->value(Keys::compressedStorage, Defaults::compressedStorage).toBool();
+}
+
+void Settings::setCompressedStorage(bool enabled)
+{
+    m_settings->setValue(Keys::compressedStorage, enabled);
+}
+
+int Settings::serverPort() const
+{
+    return m_settings->value(Keys::serverPort, Defaults::serverPort).toInt();
+}
+
+void Settings::setServerPort(int port)
+{
+    m_settings->setValue(Keys::serverPort, port);
+}
+
+QString Settings::updateLogFile() const
+{
+    return m_settings->value(Keys::updateLogFile).toString();
+}
+
+void Settings::setUpdateLogFile(const QString& file)
+{
+    m_settings->setValue(Keys::updateLogFile, file);
+}
+
 QByteArray Settings::mainWindowGeometry() const
 {
     return m_settings->value(Keys::mainWindowGeometry).toByteArray();
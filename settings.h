@@ -75,9 +75,43 @@ public:
     QDir downloadFolder() const;
     void setDownloadFolder(const QDir& folder);
 
+    int downloadSegments() const;
+    void setDownloadSegments(int segments);
+
+    int maximumDownloads() const;
+    void setMaximumDownloads(int downloads);
+
+    int maximumDownloadsPerHost() const;
+    void setMaximumDownloadsPerHost(int downloads);
+
+    // In kibibytes per second where zero means unlimited.
+    int bandwidthLimit() const;
+    void setBandwidthLimit(int kibibytesPerSecond);
+
+    bool computeChecksums() const;
+    void setComputeChecksums(bool enabled);
+
     Url preferredUrl() const;
     void setPreferredUrl(const Url type);
 
+    bool inMemoryCatalogue() const;
+    void setInMemoryCatalogue(bool enabled);
+
+    // In mebibytes up to one gibibyte where zero disables caching query results.
+    int queryCacheSize() const;
+    void setQueryCacheSize(int mebibytes);
+
+    // Compresses descriptions and factors out common URL prefixes when storing shows.
+    bool compressedStorage() const;
+    void setCompressedStorage(bool enabled);
+
+    // The port of the local query service where zero disables it.
+    int serverPort() const;
+    void setServerPort(int port);
+
+    QString updateLogFile() const;
+    void setUpdateLogFile(const QString& file);
+
     QByteArray mainWindowGeometry() const;
     void setMainWindowGeometry(const QByteArray& geometry);
 
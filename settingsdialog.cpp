@@ -22,6 +22,7 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 #include "settingsdialog.h"
 
 #include <QAction>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QDialogButtonBox>
 #include <QFileDialog>
@@ -72,6 +73,37 @@ SettingsDialog::SettingsDialog(
     const auto selectDownloadFolderAction = m_downloadFolderEdit->addAction(QIcon::fromTheme(QStringLiteral("document-open")), QLineEdit::TrailingPosition);
     connect(selectDownloadFolderAction, &QAction::triggered, this, &SettingsDialog::selectDownloadFolder);
 
+    // Qt does not open more than six connections per host anyway.
+    m_downloadSegmentsBox = new QSpinBox(this);
+    m_downloadSegmentsBox->setRange(1, 6);
+    m_downloadSegmentsBox->setValue(m_settings.downloadSegments());
+    m_downloadSegmentsBox->setSuffix(tr(" connections"));
+    m_downloadSegmentsBox->setToolTip(tr("Downloads are split into segments fetched in parallel if the server supports range requests."));
+    layout->addRow(tr("Download segments"), m_downloadSegmentsBox);
+
+    m_maximumDownloadsBox = new QSpinBox(this);
+    m_maximumDownloadsBox->setRange(1, 16);
+    m_maximumDownloadsBox->setValue(m_settings.maximumDownloads());
+    layout->addRow(tr("Parallel downloads"), m_maximumDownloadsBox);
+
+    m_maximumDownloadsPerHostBox = new QSpinBox(this);
+    m_maximumDownloadsPerHostBox->setRange(1, 16);
+    m_maximumDownloadsPerHostBox->setValue(m_settings.maximumDownloadsPerHost());
+    layout->addRow(tr("Parallel downloads per host"), m_maximumDownloadsPerHostBox);
+
+    m_bandwidthLimitBox = new QSpinBox(this);
+    m_bandwidthLimitBox->setRange(0, 1024 * 1024);
+    m_bandwidthLimitBox->setSingleStep(128);
+    m_bandwidthLimitBox->setValue(m_settings.bandwidthLimit());
+    m_bandwidthLimitBox->setSuffix(tr(" KiB/s"));
+    m_bandwidthLimitBox->setSpecialValueText(tr("Unlimited"));
+    layout->addRow(tr("Bandwidth limit"), m_bandwidthLimitBox);
+
+    m_computeChecksumsBox = new QCheckBox(this);
+    m_computeChecksumsBox->setChecked(m_settings.computeChecksums());
+    m_computeChecksumsBox->setToolTip(tr("Computes the SHA-256 of downloaded files while they are written."));
+    layout->addRow(tr("Download checksums"), m_computeChecksumsBox);
+
     m_preferredUrlBox = new QComboBox(this);
     m_preferredUrlBox->addItem(tr("Default"), int(Url::Default));
     m_preferredUrlBox->addItem(tr("Small"), int(Url::Small));
@@ -79,6 +111,31 @@ SettingsDialog::SettingsDialog(
     m_preferredUrlBox->setCurrentIndex(m_preferredUrlBox->findData(int(m_settings.preferredUrl())));
     layout->addRow(tr("Preferred URL"), m_preferredUrlBox);
 
+    m_inMemoryCatalogueBox = new QCheckBox(this);
+    m_inMemoryCatalogueBox->setChecked(m_settings.inMemoryCatalogue());
+    m_inMemoryCatalogueBox->setToolTip(tr("Takes effect after restarting the application."));
+    layout->addRow(tr("In-memory catalogue"), m_inMemoryCatalogueBox);
+
+    m_queryCacheSizeBox = new QSpinBox(this);
+    m_queryCacheSizeBox->setRange(0, 1024);
+    m_queryCacheSizeBox->setValue(m_settings.queryCacheSize());
+    m_queryCacheSizeBox->setSuffix(tr(" MiB"));
+    m_queryCacheSizeBox->setSpecialValueText(tr("Disabled"));
+    m_queryCacheSizeBox->setToolTip(tr("Keeps the results of recent searches. Takes effect after restarting the application."));
+    layout->addRow(tr("Query cache"), m_queryCacheSizeBox);
+
+    m_compressedStorageBox = new QCheckBox(this);
+    m_compressedStorageBox->setChecked(m_settings.compressedStorage());
+    m_compressedStorageBox->setToolTip(tr("Shrinks the database at the cost of slower updates. Applies to shows stored by subsequent updates."));
+    layout->addRow(tr("Compressed storage"), m_compressedStorageBox);
+
+    m_serverPortBox = new QSpinBox(this);
+    m_serverPortBox->setRange(0, 65535);
+    m_serverPortBox->setValue(m_settings.serverPort());
+    m_serverPortBox->setSpecialValueText(tr("Disabled"));
+    m_serverPortBox->setToolTip(tr("Serves search requests of local tools via HTTP. Takes effect after restarting the application."));
+    layout->addRow(tr("Query service port"), m_serverPortBox);
+
     auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
     layout->addWidget(buttonBox);
 
@@ -101,8 +158,19 @@ void SettingsDialog::accept()
     m_settings.setDownloadCommand(m_downloadCommandEdit->text());
 
     m_settings.setDownloadFolder(m_downloadFolderEdit->text());
+    m_settings.setDownloadSegments(m_downloadSegmentsBox->value());
+
+    m_settings.setMaximumDownloads(m_maximumDownloadsBox->value());
+    m_settings.setMaximumDownloadsPerHost(m_maximumDownloadsPerHostBox->value());
+    m_settings.setBandwidthLimit(m_bandwidthLimitBox->value());
+    m_settings.setComputeChecksums(m_computeChecksumsBox->isChecked());
 
     m_settings.setPreferredUrl(Url(m_preferredUrlBox->currentData().toInt()));
+
+    m_settings.setInMemoryCatalogue(m_inMemoryCatalogueBox->isChecked());
+    m_settings.setQueryCacheSize(m_queryCacheSizeBox->value());
+    m_settings.setCompressedStorage(m_compressedStorageBox->isChecked());
+    m_settings.setServerPort(m_serverPortBox->value());
 }
 
 void SettingsDialog::selectDownloadFolder()
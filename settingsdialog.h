@@ -24,6 +24,7 @@ along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDialog>
 
+class QCheckBox;
 class QComboBox;
 class QLineEdit;
 class QSpinBox;
@@ -58,9 +59,21 @@ private:
     QLineEdit* m_downloadCommandEdit;
 
     QLineEdit* m_downloadFolderEdit;
+    QSpinBox* m_downloadSegmentsBox;
+
+    QSpinBox* m_maximumDownloadsBox;
+    QSpinBox* m_maximumDownloadsPerHostBox;
+    QSpinBox* m_bandwidthLimitBox;
+    QCheckBox* m_computeChecksumsBox;
 
     QComboBox* m_preferredUrlBox;
 
+    QCheckBox* m_inMemoryCatalogueBox;
+    QSpinBox* m_queryCacheSizeBox;
+    QCheckBox* m_compressedStorageBox;
+
+    QSpinBox* m_serverPortBox;
+
 };
 
 } // QMediathekView
@@ -0,0 +1,233 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "httpserver.h"
+
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+// Parses a header of the form "bytes=100-199" where the end may be omitted.
+bool parseRange(const QByteArray& header, const qint64 size, qint64& begin, qint64& end)
+{
+    const auto prefix = QByteArrayLiteral("bytes=");
+
+    if (!header.startsWith(prefix))
+    {
+        return false;
+    }
+
+    const auto dash = header.indexOf('-', prefix.size());
+
+    if (dash < 0)
+    {
+        return false;
+    }
+
+    bool ok = false;
+
+    begin = header.mid(prefix.size(), dash - prefix.size()).toLongLong(&ok);
+
+    if (!ok || begin >= size)
+    {
+        return false;
+    }
+
+    end = size - 1;
+
+    if (dash + 1 < header.size())
+    {
+        end = qMin(end, header.mid(dash + 1).toLongLong(&ok));
+    }
+
+    return ok && begin <= end;
+}
+
+void send(QTcpSocket* socket, const QByteArray& status, const QByteArray& headers, const QByteArray& body)
+{
+    QByteArray response = QByteArrayLiteral("HTTP/1.1 ") + status + "\r\n";
+
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Content-Type: application/octet-stream\r\n";
+    response += "ETag: \"fixture\"\r\n";
+    response += "Connection: close\r\n";
+    response += headers;
+    response += "\r\n";
+
+    socket->write(response);
+    socket->write(body);
+    socket->disconnectFromHost();
+}
+
+} // anonymous
+
+HttpServer::HttpServer(QObject* parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+    , m_rangesSupported(true)
+    , m_fullResponses(0)
+    , m_partialResponses(0)
+{
+    connect(m_server, &QTcpServer::newConnection, this, &HttpServer::accept);
+}
+
+HttpServer::~HttpServer()
+{
+}
+
+bool HttpServer::listen()
+{
+    return m_server->listen(QHostAddress::LocalHost);
+}
+
+QUrl HttpServer::url(const QString& path) const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:%1%2").arg(m_server->serverPort()).arg(path));
+}
+
+void HttpServer::setResource(const QString& path, const QByteArray& data)
+{
+    m_resources.insert(path, data);
+}
+
+void HttpServer::setRangesSupported(const bool rangesSupported)
+{
+    m_rangesSupported = rangesSupported;
+}
+
+int HttpServer::fullResponses() const
+{
+    return m_fullResponses;
+}
+
+int HttpServer::partialResponses() const
+{
+    return m_partialResponses;
+}
+
+void HttpServer::resetCounters()
+{
+    m_fullResponses = 0;
+    m_partialResponses = 0;
+}
+
+void HttpServer::accept()
+{
+    while (m_server->hasPendingConnections())
+    {
+        const auto socket = m_server->nextPendingConnection();
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]()
+        {
+            read(socket);
+        });
+
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]()
+        {
+            m_requests.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void HttpServer::read(QTcpSocket* socket)
+{
+    auto& request = m_requests[socket];
+
+    request += socket->readAll();
+
+    const auto end = request.indexOf("\r\n\r\n");
+
+    if (end < 0)
+    {
+        return;
+    }
+
+    const auto header = request.left(end);
+
+    // Since every connection is closed after its response, anything following the first request is ignored.
+    request.clear();
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    respond(socket, header);
+}
+
+void HttpServer::respond(QTcpSocket* socket, const QByteArray& request)
+{
+    const auto lines = request.split('\n');
+    const auto requestLine = lines.first().trimmed().split(' ');
+
+    if (requestLine.size() < 2 || requestLine.at(0) != "GET")
+    {
+        send(socket, "405 Method Not Allowed", QByteArray(), QByteArray());
+        return;
+    }
+
+    QByteArray range;
+
+    for (const auto& line : lines.mid(1))
+    {
+        const auto colon = line.indexOf(':');
+
+        if (colon > 0 && line.left(colon).trimmed().toLower() == "range")
+        {
+            range = line.mid(colon + 1).trimmed();
+        }
+    }
+
+    const auto path = QUrl(QString::fromUtf8(requestLine.at(1))).path();
+    const auto resource = m_resources.constFind(path);
+
+    if (resource == m_resources.constEnd())
+    {
+        send(socket, "404 Not Found", QByteArray(), QByteArray());
+        return;
+    }
+
+    const auto& data = resource.value();
+
+    qint64 begin = 0;
+    qint64 end = 0;
+
+    if (m_rangesSupported && parseRange(range, data.size(), begin, end))
+    {
+        ++m_partialResponses;
+
+        const auto contentRange = "Content-Range: bytes " + QByteArray::number(begin) + '-' + QByteArray::number(end) + '/' + QByteArray::number(data.size()) + "\r\n";
+
+        send(socket, "206 Partial Content", "Accept-Ranges: bytes\r\n" + contentRange, data.mid(begin, end - begin + 1));
+    }
+    else
+    {
+        ++m_fullResponses;
+
+        send(socket, "200 OK", QByteArray(), data);
+    }
+}
+
+} // QMediathekView
@@ -0,0 +1,78 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QUrl>
+
+class QTcpServer;
+class QTcpSocket;
+
+namespace QMediathekView
+{
+
+// Serves fixed resources over HTTP on the loopback interface, closing the connection after each response.
+class HttpServer : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpServer)
+
+public:
+    explicit HttpServer(QObject* parent = 0);
+    ~HttpServer();
+
+    bool listen();
+    QUrl url(const QString& path) const;
+
+    void setResource(const QString& path, const QByteArray& data);
+
+    // Without range support, the whole resource is sent with status 200 regardless of the Range header.
+    void setRangesSupported(const bool rangesSupported);
+
+    int fullResponses() const;
+    int partialResponses() const;
+    void resetCounters();
+
+private:
+    QTcpServer* m_server;
+
+    QHash< QString, QByteArray > m_resources;
+    QHash< QTcpSocket*, QByteArray > m_requests;
+
+    bool m_rangesSupported;
+
+    int m_fullResponses;
+    int m_partialResponses;
+
+    void accept();
+    void read(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, const QByteArray& request);
+
+};
+
+} // QMediathekView
+
+#endif // HTTPSERVER_H
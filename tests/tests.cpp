@@ -0,0 +1,397 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <memory>
+
+#include <QFile>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "download.h"
+#include "hlsdownload.h"
+#include "httpserver.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto timeout = 30 * 1000;
+
+constexpr auto window = 3;
+
+QByteArray fixture(const QString& name)
+{
+    QFile file(QStringLiteral(":/fixtures/") + name);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qFatal("Failed to open fixture %s.", qPrintable(name));
+    }
+
+    return file.readAll();
+}
+
+// Generates data which differs between resources and within them so that misplaced ranges are detected.
+QByteArray pattern(const int size, const int seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+
+    for (int index = 0; index < size; ++index)
+    {
+        data[index] = char((index * 31 + index / 251 + seed * 17) & 0xff);
+    }
+
+    return data;
+}
+
+QByteArray contents(const QString& filePath)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+
+    return file.readAll();
+}
+
+bool run(Transfer& transfer)
+{
+    QSignalSpy spy(&transfer, &Transfer::finished);
+
+    transfer.start();
+
+    if (spy.isEmpty() && !spy.wait(timeout))
+    {
+        return false;
+    }
+
+    return spy.first().first().toBool();
+}
+
+} // anonymous
+
+class Tests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void parseMasterPlaylist();
+    void parseMediaPlaylist();
+    void parseByteRanges();
+    void parseEncryptedPlaylist();
+    void parseMalformedPlaylist();
+
+    void selectVariant_data();
+    void selectVariant();
+
+    void downloadByteRanges_data();
+    void downloadByteRanges();
+
+    void rejectEncryptedStream();
+
+    void downloadSegments_data();
+    void downloadSegments();
+
+private:
+    HttpServer m_server;
+    QNetworkAccessManager m_networkManager;
+
+    std::unique_ptr< QTemporaryDir > m_directory;
+
+    QHash< QString, QByteArray > m_variants;
+    QByteArray m_media;
+    QByteArray m_show;
+
+};
+
+void Tests::initTestCase()
+{
+    m_networkManager.setProxy(QNetworkProxy::NoProxy);
+
+    QVERIFY(m_server.listen());
+
+    const auto playlists = {
+        QStringLiteral("master.m3u8"),
+        QStringLiteral("low.m3u8"),
+        QStringLiteral("medium.m3u8"),
+        QStringLiteral("high.m3u8"),
+        QStringLiteral("byterange.m3u8"),
+        QStringLiteral("encrypted.m3u8")
+    };
+
+    for (const auto& playlist : playlists)
+    {
+        m_server.setResource(QStringLiteral("/streams/") + playlist, fixture(playlist));
+    }
+
+    const auto variants = { QStringLiteral("low"), QStringLiteral("medium"), QStringLiteral("high") };
+
+    auto seed = 0;
+
+    for (const auto& variant : variants)
+    {
+        for (int index = 0; index < 2; ++index)
+        {
+            const auto data = pattern(4000 + index, ++seed);
+
+            m_server.setResource(QStringLiteral("/streams/%1-%2.ts").arg(variant).arg(index), data);
+            m_variants[variant] += data;
+        }
+    }
+
+    // Matches the byte ranges of the initialization section and the three media segments of the fixture.
+    m_media = pattern(3000, ++seed);
+    m_server.setResource(QStringLiteral("/streams/media.mp4"), m_media);
+
+    // Large enough to be split into several segments of at least one mebibyte.
+    m_show = pattern(3 * 1024 * 1024 + 12345, ++seed);
+    m_server.setResource(QStringLiteral("/show.mp4"), m_show);
+}
+
+void Tests::init()
+{
+    m_directory.reset(new QTemporaryDir);
+    QVERIFY(m_directory->isValid());
+
+    m_server.setRangesSupported(true);
+    m_server.resetCounters();
+}
+
+void Tests::parseMasterPlaylist()
+{
+    const QUrl baseUrl(QStringLiteral("http://example.org/streams/master.m3u8"));
+
+    HlsDownload::Playlist playlist;
+    QVERIFY(HlsDownload::parse(fixture(QStringLiteral("master.m3u8")), baseUrl, playlist));
+
+    QVERIFY(playlist.segments.isEmpty());
+    QVERIFY(!playlist.encrypted);
+
+    QCOMPARE(playlist.variants.size(), 3);
+
+    QCOMPARE(playlist.variants.at(0).url, QUrl(QStringLiteral("http://example.org/streams/high.m3u8")));
+    QCOMPARE(playlist.variants.at(0).bandwidth, qint64(3000000));
+
+    QCOMPARE(playlist.variants.at(1).url, QUrl(QStringLiteral("http://example.org/streams/low.m3u8")));
+    QCOMPARE(playlist.variants.at(1).bandwidth, qint64(500000));
+
+    QCOMPARE(playlist.variants.at(2).url, QUrl(QStringLiteral("http://example.org/streams/medium.m3u8")));
+    QCOMPARE(playlist.variants.at(2).bandwidth, qint64(1500000));
+}
+
+void Tests::parseMediaPlaylist()
+{
+    const QUrl baseUrl(QStringLiteral("http://example.org/streams/low.m3u8"));
+
+    HlsDownload::Playlist playlist;
+    QVERIFY(HlsDownload::parse(fixture(QStringLiteral("low.m3u8")), baseUrl, playlist));
+
+    QVERIFY(playlist.variants.isEmpty());
+    QVERIFY(!playlist.encrypted);
+
+    QCOMPARE(playlist.segments.size(), 2);
+
+    for (int index = 0; index < 2; ++index)
+    {
+        const auto& segment = playlist.segments.at(index);
+
+        QCOMPARE(segment.url, QUrl(QStringLiteral("http://example.org/streams/low-%1.ts").arg(index)));
+        QCOMPARE(segment.offset, qint64(0));
+        QCOMPARE(segment.length, qint64(-1));
+    }
+}
+
+void Tests::parseByteRanges()
+{
+    const QUrl baseUrl(QStringLiteral("http://example.org/streams/byterange.m3u8"));
+    const QUrl mediaUrl(QStringLiteral("http://example.org/streams/media.mp4"));
+
+    HlsDownload::Playlist playlist;
+    QVERIFY(HlsDownload::parse(fixture(QStringLiteral("byterange.m3u8")), baseUrl, playlist));
+
+    QVERIFY(!playlist.encrypted);
+
+    // The initialization section comes first and ranges without offset continue where the previous one ended.
+    const qint64 expected[][2] = { { 0, 100 }, { 100, 1000 }, { 1100, 1000 }, { 2100, 900 } };
+
+    QCOMPARE(playlist.segments.size(), 4);
+
+    for (int index = 0; index < 4; ++index)
+    {
+        const auto& segment = playlist.segments.at(index);
+
+        QCOMPARE(segment.url, mediaUrl);
+        QCOMPARE(segment.offset, expected[index][0]);
+        QCOMPARE(segment.length, expected[index][1]);
+    }
+}
+
+void Tests::parseEncryptedPlaylist()
+{
+    const QUrl baseUrl(QStringLiteral("http://example.org/streams/encrypted.m3u8"));
+
+    HlsDownload::Playlist playlist;
+    QVERIFY(HlsDownload::parse(fixture(QStringLiteral("encrypted.m3u8")), baseUrl, playlist));
+
+    QVERIFY(playlist.encrypted);
+    QCOMPARE(playlist.segments.size(), 1);
+
+    QVERIFY(HlsDownload::parse("#EXTM3U\n#EXT-X-KEY:METHOD=NONE\n#EXTINF:10.0,\nlow-0.ts\n", baseUrl, playlist));
+    QVERIFY(!playlist.encrypted);
+}
+
+void Tests::parseMalformedPlaylist()
+{
+    const QUrl baseUrl(QStringLiteral("http://example.org/streams/index.m3u8"));
+
+    HlsDownload::Playlist playlist;
+
+    QVERIFY(!HlsDownload::parse(QByteArray(), baseUrl, playlist));
+    QVERIFY(!HlsDownload::parse("<html></html>\n", baseUrl, playlist));
+    QVERIFY(!HlsDownload::parse("#EXTM3U\n#EXT-X-BYTERANGE:many\nmedia.mp4\n", baseUrl, playlist));
+    QVERIFY(!HlsDownload::parse("#EXTM3U\n#EXT-X-MAP:URI=\"media.mp4\",BYTERANGE=\"100@none\"\n", baseUrl, playlist));
+}
+
+void Tests::selectVariant_data()
+{
+    QTest::addColumn< int >("variant");
+    QTest::addColumn< QString >("name");
+
+    QTest::newRow("small") << int(Url::Small) << QStringLiteral("low");
+    QTest::newRow("default") << int(Url::Default) << QStringLiteral("medium");
+    QTest::newRow("large") << int(Url::Large) << QStringLiteral("high");
+}
+
+void Tests::selectVariant()
+{
+    QFETCH(int, variant);
+    QFETCH(QString, name);
+
+    const auto filePath = m_directory->filePath(QStringLiteral("show.ts"));
+
+    HlsDownload download(&m_networkManager, QStringLiteral("tests"), m_server.url(QStringLiteral("/streams/master.m3u8")), filePath, Url(variant), window, nullptr);
+
+    QVERIFY2(run(download), qPrintable(download.errorString()));
+
+    QCOMPARE(contents(filePath), m_variants.value(name));
+
+    // Besides the master playlist, only the chosen variant and its segments were requested.
+    QCOMPARE(m_server.fullResponses(), 4);
+}
+
+void Tests::downloadByteRanges_data()
+{
+    QTest::addColumn< bool >("rangesSupported");
+
+    QTest::newRow("partial content") << true;
+    QTest::newRow("whole resource") << false;
+}
+
+void Tests::downloadByteRanges()
+{
+    QFETCH(bool, rangesSupported);
+
+    m_server.setRangesSupported(rangesSupported);
+
+    const auto filePath = m_directory->filePath(QStringLiteral("show.mp4"));
+
+    HlsDownload download(&m_networkManager, QStringLiteral("tests"), m_server.url(QStringLiteral("/streams/byterange.m3u8")), filePath, Url::Default, window, nullptr);
+
+    QVERIFY2(run(download), qPrintable(download.errorString()));
+
+    // Servers ignoring the range send the whole resource from which the segment is cut.
+    QCOMPARE(contents(filePath), m_media);
+    QCOMPARE(m_server.partialResponses(), rangesSupported ? 4 : 0);
+
+    QVERIFY(!QFile::exists(filePath + QStringLiteral(".part")));
+}
+
+void Tests::rejectEncryptedStream()
+{
+    const auto filePath = m_directory->filePath(QStringLiteral("show.ts"));
+
+    HlsDownload download(&m_networkManager, QStringLiteral("tests"), m_server.url(QStringLiteral("/streams/encrypted.m3u8")), filePath, Url::Default, window, nullptr);
+
+    QVERIFY(!run(download));
+    QCOMPARE(download.errorString(), HlsDownload::tr("Encrypted streams are not supported."));
+
+    // Only the playlist was requested since none of its segments can be used.
+    QCOMPARE(m_server.fullResponses(), 1);
+
+    QVERIFY(!QFile::exists(filePath));
+}
+
+void Tests::downloadSegments_data()
+{
+    QTest::addColumn< bool >("rangesSupported");
+
+    QTest::newRow("partial content") << true;
+    QTest::newRow("whole resource") << false;
+}
+
+void Tests::downloadSegments()
+{
+    QFETCH(bool, rangesSupported);
+
+    m_server.setRangesSupported(rangesSupported);
+
+    const auto filePath = m_directory->filePath(QStringLiteral("show.mp4"));
+
+    Download download(&m_networkManager, QStringLiteral("tests"), m_server.url(QStringLiteral("/show.mp4")), filePath, 4, nullptr);
+
+    QVERIFY2(run(download), qPrintable(download.errorString()));
+
+    QCOMPARE(contents(filePath), m_show);
+
+    if (rangesSupported)
+    {
+        // The open-ended first request is cut down to its segment once the size is known.
+        QVERIFY(m_server.partialResponses() >= 3);
+        QCOMPARE(m_server.fullResponses(), 0);
+    }
+    else
+    {
+        // The server ignored the range, so the download fell back to a single stream.
+        QCOMPARE(m_server.partialResponses(), 0);
+        QCOMPARE(m_server.fullResponses(), 1);
+    }
+
+    QVERIFY(!QFile::exists(filePath + QStringLiteral(".part")));
+    QVERIFY(!QFile::exists(filePath + QStringLiteral(".part.json")));
+}
+
+} // QMediathekView
+
+QTEST_GUILESS_MAIN(QMediathekView::Tests)
+
+#include "tests.moc"
@@ -0,0 +1,31 @@
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+QT += core network testlib
+QT -= gui
+
+TARGET = tests
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../trace.cpp \
+    ../tokenbucket.cpp \
+    ../transfer.cpp \
+    ../download.cpp \
+    ../hlsdownload.cpp \
+    httpserver.cpp \
+    tests.cpp
+
+HEADERS += \
+    ../trace.h \
+    ../schema.h \
+    ../tokenbucket.h \
+    ../transfer.h \
+    ../download.h \
+    ../hlsdownload.h \
+    httpserver.h
+
+RESOURCES += \
+    fixtures.qrc
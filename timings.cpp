@@ -0,0 +1,159 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "timings.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif // Q_OS_UNIX
+
+#include "settings.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+// Returns the peak resident set size of the whole process in kibibytes.
+qint64 peakResidentSetSize()
+{
+#ifdef Q_OS_UNIX
+
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return usage.ru_maxrss;
+    }
+
+#endif // Q_OS_UNIX
+
+    return -1;
+}
+
+} // anonymous
+
+Timings::Timings(const Settings& settings, QObject* parent)
+    : QObject(parent)
+    , m_settings(settings)
+    , m_success(false)
+{
+}
+
+Timings::~Timings()
+{
+}
+
+void Timings::start()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_startedOn = QDateTime::currentDateTime();
+    m_timer.start();
+    m_success = false;
+
+    m_stages.clear();
+}
+
+void Timings::record(const QString& name, const qint64 nanoseconds, const qint64 bytes, const qint64 rows)
+{
+    const Stage stage = { name, nanoseconds, bytes, rows, peakResidentSetSize() };
+
+    QMutexLocker locker(&m_mutex);
+
+    m_stages.append(stage);
+}
+
+void Timings::finish(const bool success)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_timer.isValid())
+        {
+            return;
+        }
+
+        const Stage stage = { QStringLiteral("total"), m_timer.nsecsElapsed(), 0, 0, peakResidentSetSize() };
+
+        m_stages.append(stage);
+        m_timer.invalidate();
+        m_success = success;
+    }
+
+    const auto logFile = m_settings.updateLogFile();
+
+    if (!logFile.isEmpty())
+    {
+        QFile file(logFile);
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)
+                || file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Compact).append('\n')) == -1)
+        {
+            qDebug() << "Failed to write update log:" << file.errorString();
+        }
+    }
+
+    emit finished();
+}
+
+QVector< Timings::Stage > Timings::stages() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_stages;
+}
+
+QJsonObject Timings::toJson() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QJsonArray stages;
+
+    for (const auto& stage : m_stages)
+    {
+        QJsonObject object;
+
+        object.insert(QStringLiteral("name"), stage.name);
+        object.insert(QStringLiteral("milliseconds"), stage.nanoseconds / 1000.0 / 1000.0);
+        object.insert(QStringLiteral("bytes"), double(stage.bytes));
+        object.insert(QStringLiteral("rows"), double(stage.rows));
+        object.insert(QStringLiteral("peakResidentSetSize"), double(stage.peakResidentSetSize));
+
+        stages.append(object);
+    }
+
+    QJsonObject object;
+
+    object.insert(QStringLiteral("startedOn"), m_startedOn.toString(Qt::ISODate));
+    object.insert(QStringLiteral("success"), m_success);
+    object.insert(QStringLiteral("stages"), stages);
+
+    return object;
+}
+
+} // QMediathekView
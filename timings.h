@@ -0,0 +1,81 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TIMINGS_H
+#define TIMINGS_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+namespace QMediathekView
+{
+
+class Settings;
+
+class Timings : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Timings)
+
+public:
+    explicit Timings(const Settings& settings, QObject* parent = 0);
+    ~Timings();
+
+    struct Stage
+    {
+        QString name;
+        qint64 nanoseconds;
+        qint64 bytes;
+        qint64 rows;
+        qint64 peakResidentSetSize;
+    };
+
+signals:
+    void finished();
+
+public:
+    void start();
+    void record(const QString& name, const qint64 nanoseconds, const qint64 bytes = 0, const qint64 rows = 0);
+    void finish(const bool success);
+
+    QVector< Stage > stages() const;
+    QJsonObject toJson() const;
+
+private:
+    const Settings& m_settings;
+
+    mutable QMutex m_mutex;
+
+    QDateTime m_startedOn;
+    QElapsedTimer m_timer;
+    bool m_success;
+
+    QVector< Stage > m_stages;
+
+};
+
+} // QMediathekView
+
+#endif // TIMINGS_H
@@ -0,0 +1,108 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "tokenbucket.h"
+
+#include <QTimer>
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+constexpr auto refillInterval = 50;
+
+constexpr qint64 minimumCapacity = 16 * 1024;
+
+} // anonymous
+
+TokenBucket::TokenBucket(QObject* parent)
+    : QObject(parent)
+    , m_rate(0)
+    , m_capacity(0)
+    , m_tokens(0)
+    , m_refillTimer(new QTimer(this))
+{
+    m_refillTimer->setInterval(refillInterval);
+
+    connect(m_refillTimer, &QTimer::timeout, this, &TokenBucket::refilled);
+}
+
+TokenBucket::~TokenBucket()
+{
+}
+
+void TokenBucket::setRate(const qint64 bytesPerSecond)
+{
+    if (m_rate == bytesPerSecond)
+    {
+        return;
+    }
+
+    m_rate = qMax(qint64(0), bytesPerSecond);
+
+    // Allows bursts of a quarter second so that readers woken up by the timer are not starved.
+    m_capacity = qMax(minimumCapacity, m_rate / 4);
+    m_tokens = qMin(m_tokens, m_capacity);
+
+    if (m_rate > 0)
+    {
+        m_timer.start();
+        m_refillTimer->start();
+    }
+    else
+    {
+        m_refillTimer->stop();
+
+        // Readers waiting for tokens would otherwise never be woken up.
+        emit refilled();
+    }
+}
+
+qint64 TokenBucket::take(const qint64 bytes)
+{
+    if (m_rate <= 0)
+    {
+        return bytes;
+    }
+
+    refill();
+
+    const auto taken = qMin(bytes, m_tokens);
+    m_tokens -= taken;
+
+    return taken;
+}
+
+void TokenBucket::refill()
+{
+    const auto tokens = m_rate * m_timer.elapsed() / 1000;
+
+    // The timer is only restarted once whole tokens accumulated so that fractions are not lost.
+    if (tokens > 0)
+    {
+        m_tokens = qMin(m_capacity, m_tokens + tokens);
+        m_timer.restart();
+    }
+}
+
+} // QMediathekView
@@ -0,0 +1,65 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+class QTimer;
+
+namespace QMediathekView
+{
+
+class TokenBucket : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TokenBucket)
+
+public:
+    explicit TokenBucket(QObject* parent = 0);
+    ~TokenBucket();
+
+signals:
+    void refilled();
+
+public:
+    // A rate of zero disables the limit.
+    void setRate(const qint64 bytesPerSecond);
+
+    qint64 take(const qint64 bytes);
+
+private:
+    qint64 m_rate;
+    qint64 m_capacity;
+    qint64 m_tokens;
+
+    QElapsedTimer m_timer;
+    QTimer* m_refillTimer;
+
+    void refill();
+
+};
+
+} // QMediathekView
+
+#endif // TOKENBUCKET_H
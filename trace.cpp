@@ -0,0 +1,225 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "trace.h"
+
+#ifdef QMEDIATHEKVIEW_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QTextStream>
+
+namespace QMediathekView
+{
+
+namespace Trace
+{
+
+namespace
+{
+
+constexpr std::size_t bufferSize = 64 * 1024;
+
+struct Event
+{
+    const char* name;
+    qint64 begin;
+    qint64 end;
+};
+
+// The sequence is the index of the event plus one once it is completely written and zero while it is being written.
+struct Slot
+{
+    std::atomic< quint64 > sequence;
+    Event event;
+};
+
+// Written only by its owning thread whereas dumping uses the sequence of each slot to skip events overwritten meanwhile.
+struct Buffer
+{
+    explicit Buffer(const int thread)
+        : thread(thread)
+        , head(0)
+        , slots(new Slot[bufferSize])
+    {
+        for (std::size_t index = 0; index < bufferSize; ++index)
+        {
+            slots[index].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    const int thread;
+
+    std::atomic< quint64 > head;
+    std::unique_ptr< Slot[] > slots;
+};
+
+// Buffers are never released so that events of finished threads can still be dumped.
+struct Registry
+{
+    QMutex mutex;
+    std::vector< std::unique_ptr< Buffer > > buffers;
+};
+
+Registry& registry()
+{
+    static Registry registry;
+
+    return registry;
+}
+
+Buffer& buffer()
+{
+    static thread_local Buffer* buffer = nullptr;
+
+    if (buffer == nullptr)
+    {
+        auto& registry = Trace::registry();
+
+        QMutexLocker locker(&registry.mutex);
+
+        registry.buffers.emplace_back(new Buffer(registry.buffers.size() + 1));
+        buffer = registry.buffers.back().get();
+    }
+
+    return *buffer;
+}
+
+const auto epoch = std::chrono::steady_clock::now();
+
+void writeEscaped(QTextStream& stream, const char* name)
+{
+    for (; *name != '\0'; ++name)
+    {
+        if (*name == '"' || *name == '\\')
+        {
+            stream << '\\';
+        }
+
+        stream << *name;
+    }
+}
+
+} // anonymous
+
+qint64 now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record(const char* name, const qint64 begin, const qint64 end)
+{
+    auto& buffer = Trace::buffer();
+
+    const auto head = buffer.head.load(std::memory_order_relaxed);
+
+    auto& slot = buffer.slots[head % bufferSize];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.event = { name, begin, end };
+
+    slot.sequence.store(head + 1, std::memory_order_release);
+
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+bool dump(const QString& fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(3);
+
+    stream << "{\"traceEvents\":[";
+
+    const auto pid = QCoreApplication::applicationPid();
+    auto first = true;
+
+    auto& registry = Trace::registry();
+
+    QMutexLocker locker(&registry.mutex);
+
+    for (const auto& buffer : registry.buffers)
+    {
+        const auto head = buffer->head.load(std::memory_order_acquire);
+        const auto tail = head > bufferSize ? head - bufferSize : 0;
+
+        for (auto index = tail; index < head; ++index)
+        {
+            const auto& slot = buffer->slots[index % bufferSize];
+
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Skip events which the owning thread is overwriting or has overwritten while we were copying them.
+            if (sequence != index + 1 || slot.sequence.load(std::memory_order_relaxed) != sequence)
+            {
+                continue;
+            }
+
+            stream << (first ? "" : ",") << "\n{\"name\":\"";
+            writeEscaped(stream, event.name);
+            stream << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->thread
+                   << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << '}';
+
+            first = false;
+        }
+    }
+
+    stream << "\n]}\n";
+    stream.flush();
+
+    return file.error() == QFileDevice::NoError;
+}
+
+QString defaultFileName()
+{
+    const auto fileName = qgetenv("QMEDIATHEKVIEW_TRACE");
+
+    if (!fileName.isEmpty())
+    {
+        return QString::fromLocal8Bit(fileName);
+    }
+
+    return QDir::temp().filePath(QStringLiteral("QMediathekView-%1.json").arg(QCoreApplication::applicationPid()));
+}
+
+} // Trace
+
+} // QMediathekView
+
+#endif // QMEDIATHEKVIEW_TRACING
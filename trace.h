@@ -0,0 +1,83 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef QMEDIATHEKVIEW_TRACING
+
+#include <QString>
+
+namespace QMediathekView
+{
+
+namespace Trace
+{
+
+qint64 now();
+
+void record(const char* name, const qint64 begin, const qint64 end);
+
+// Writes all events still held in the per-thread buffers in the Chrome trace event format.
+bool dump(const QString& fileName);
+
+// Taken from the QMEDIATHEKVIEW_TRACE environment variable if set, otherwise placed in the temporary directory.
+QString defaultFileName();
+
+class Scope
+{
+public:
+    explicit Scope(const char* name)
+        : m_name(name)
+        , m_begin(now())
+    {
+    }
+
+    ~Scope()
+    {
+        record(m_name, m_begin, now());
+    }
+
+private:
+    Q_DISABLE_COPY(Scope)
+
+    const char* const m_name;
+    const qint64 m_begin;
+
+};
+
+} // Trace
+
+} // QMediathekView
+
+#define TRACE_CONCATENATE_(first, second) first##second
+#define TRACE_CONCATENATE(first, second) TRACE_CONCATENATE_(first, second)
+
+// The name must be a string literal as only the pointer is recorded.
+#define TRACE_SCOPE(name) const ::QMediathekView::Trace::Scope TRACE_CONCATENATE(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif // QMEDIATHEKVIEW_TRACING
+
+#endif // TRACE_H
@@ -0,0 +1,69 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <QByteArray>
+#include <QObject>
+
+namespace QMediathekView
+{
+
+// Common interface of the different kinds of downloads run by the download manager.
+class Transfer : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Transfer)
+
+public:
+    explicit Transfer(QObject* parent = 0);
+    ~Transfer();
+
+signals:
+    void progress(qint64 bytesReceived, qint64 bytesTotal);
+    void finished(bool success);
+
+public:
+    // Failing to open the file is reported via finished as well.
+    virtual void start() = 0;
+    virtual void abort() = 0;
+
+    virtual QString errorString() const = 0;
+
+public:
+    // The SHA-256 of the data is computed while it is written and available after finishing successfully.
+    void setComputeChecksum(const bool computeChecksum);
+    QByteArray checksum() const;
+
+protected:
+    bool computeChecksum() const;
+    void setChecksum(const QByteArray& checksum);
+
+private:
+    bool m_computeChecksum;
+    QByteArray m_checksum;
+
+};
+
+} // QMediathekView
+
+#endif // TRANSFER_H
@@ -0,0 +1,318 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "updater.h"
+
+#include <memory>
+#include <random>
+
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+
+#include "settings.h"
+#include "timings.h"
+#include "database.h"
+#include "decompressor.h"
+
+namespace QMediathekView
+{
+
+namespace
+{
+
+namespace Tags
+{
+
+const auto root = QStringLiteral("Mediathek");
+const auto server = QStringLiteral("Server");
+const auto url = QStringLiteral("URL");
+
+} // Tags
+
+QString randomItem(const QStringList& list)
+{
+    std::random_device device;
+    std::default_random_engine generator(device());
+    std::uniform_int_distribution<> distribution(0, list.size() - 1);
+
+    return list.at(distribution(generator));
+}
+
+} // anonymous
+
+Updater::Updater(Settings& settings, Timings& timings, Database& database, QObject* parent)
+    : QObject(parent)
+    , m_settings(settings)
+    , m_timings(timings)
+    , m_database(database)
+    , m_networkManager(new QNetworkAccessManager(this))
+{
+    connect(&m_database, &Database::updated, this, &Updater::completedDatabaseUpdate);
+    connect(&m_database, &Database::failedToUpdate, this, &Updater::failedToUpdateDatabase);
+
+    connect(this, &Updater::completedDatabaseUpdate, &m_timings, [this]()
+    {
+        m_timings.finish(true);
+    });
+
+    connect(this, &Updater::failedToUpdateDatabase, &m_timings, [this]()
+    {
+        m_timings.finish(false);
+    });
+}
+
+Updater::~Updater()
+{
+}
+
+void Updater::checkUpdateMirrors()
+{
+    const auto updateAfter = m_settings.mirrorsUpdateAfterDays();
+    const auto updatedOn = m_settings.mirrorsUpdatedOn();
+    const auto updatedBefore = updatedOn.daysTo(QDateTime::currentDateTime());
+
+    if (!updatedOn.isValid() || updateAfter < updatedBefore)
+    {
+        updateMirrors();
+    }
+    else
+    {
+        checkUpdateDatabase();
+    }
+}
+
+void Updater::checkUpdateDatabase()
+{
+    const auto updateAfter = m_settings.databaseUpdateAfterHours();
+    const auto updatedOn = m_settings.databaseUpdatedOn();
+    const auto updatedBefore = updatedOn.secsTo(QDateTime::currentDateTime()) / 60 / 60;
+
+    if (!updatedOn.isValid() || updateAfter < updatedBefore)
+    {
+        updateDatabase();
+    }
+}
+
+void Updater::updateMirrors()
+{
+    fetchMirrors([this]()
+    {
+        QTimer::singleShot(0, this, &Updater::checkUpdateDatabase);
+    });
+}
+
+void Updater::updateDatabase(const Kind kind)
+{
+    m_timings.start();
+
+    emit startedDatabaseUpdate();
+
+    auto full = kind == Full;
+
+    if (kind == Automatic)
+    {
+        const auto updatedOn = m_settings.databaseUpdatedOn();
+        const auto fullUpdateOn = QDateTime(QDate::currentDate(), QTime(9, 0));
+
+        full = !updatedOn.isValid() || updatedOn < fullUpdateOn;
+    }
+
+    if (full)
+    {
+        const auto url = randomItem(m_settings.fullListMirrors());
+
+        downloadDatabase(url, [this](const QByteArray& data)
+        {
+            m_database.fullUpdate(data);
+        });
+    }
+    else
+    {
+        const auto url = randomItem(m_settings.partialListMirrors());
+
+        downloadDatabase(url, [this](const QByteArray& data)
+        {
+            m_database.partialUpdate(data);
+        });
+    }
+}
+
+void Updater::update(const Kind kind)
+{
+    if (m_settings.fullListMirrors().isEmpty() || m_settings.partialListMirrors().isEmpty())
+    {
+        fetchMirrors([this, kind]()
+        {
+            updateDatabase(kind);
+        });
+    }
+    else
+    {
+        updateDatabase(kind);
+    }
+}
+
+template< typename Continuation >
+void Updater::fetchMirrors(const Continuation& continuation)
+{
+    emit startedMirrorsUpdate();
+
+    downloadMirrors(m_settings.fullListUrl(), [this, continuation](const QStringList& mirrors)
+    {
+        m_settings.setFullListMirrors(mirrors);
+
+        downloadMirrors(m_settings.partialListUrl(), [this, continuation](const QStringList& mirrors)
+        {
+            m_settings.setPartialListMirrors(mirrors);
+            m_settings.setMirrorsUpdatedOn();
+
+            emit completedMirrorsUpdate();
+
+            continuation();
+        });
+    });
+}
+
+template< typename Consumer >
+void Updater::downloadMirrors(const QString& url, const Consumer& consumer)
+{
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, m_settings.userAgent());
+
+    const auto reply = m_networkManager->get(request);
+
+    connect(reply, &QNetworkReply::finished, [this, consumer, reply]()
+    {
+        reply->deleteLater();
+
+        if (reply->error())
+        {
+            emit failedToUpdateMirrors(reply->errorString());
+            return;
+        }
+
+        QStringList mirrors;
+
+        {
+            QDomDocument document;
+            document.setContent(reply);
+
+            const auto root = document.documentElement();
+            if (root.tagName() != Tags::root)
+            {
+                emit failedToUpdateMirrors(tr("Received a malformed mirror list."));
+                return;
+            }
+
+            auto server = root.firstChildElement(Tags::server);
+
+            while (!server.isNull())
+            {
+                const auto url = server.firstChildElement(Tags::url).text();
+
+                if (!url.isEmpty())
+                {
+                    mirrors.append(url);
+                }
+
+                server = server.nextSiblingElement(Tags::server);
+            }
+        }
+
+        if (mirrors.isEmpty())
+        {
+            emit failedToUpdateMirrors(tr("Received an empty mirror list."));
+            return;
+        }
+
+        consumer(mirrors);
+    });
+}
+
+template< typename Consumer >
+void Updater::downloadDatabase(const QString& url, const Consumer& consumer)
+{
+    struct State
+    {
+        Decompressor decompressor;
+
+        QElapsedTimer download;
+        qint64 downloadedBytes = 0;
+        qint64 decompression = 0;
+    };
+
+    const auto state = std::make_shared< State >();
+
+    const auto appendData = [state](const QByteArray& data)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        state->downloadedBytes += data.size();
+        state->decompressor.appendData(data);
+
+        state->decompression += timer.nsecsElapsed();
+    };
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, m_settings.userAgent());
+
+    state->download.start();
+
+    const auto reply = m_networkManager->get(request);
+
+    connect(reply, &QNetworkReply::readyRead, [this, reply, appendData]()
+    {
+        if (reply->error())
+        {
+            return;
+        }
+
+        appendData(reply->readAll());
+    });
+
+    connect(reply, &QNetworkReply::finished, [this, consumer, reply, state, appendData]()
+    {
+        reply->deleteLater();
+
+        if (reply->error())
+        {
+            emit failedToUpdateDatabase(reply->errorString());
+            return;
+        }
+
+        appendData(reply->readAll());
+
+        const auto& data = state->decompressor.data();
+
+        // Decompression happens incrementally while the download is running and is therefore reported separately.
+        m_timings.record(QStringLiteral("download"), state->download.nsecsElapsed() - state->decompression, state->downloadedBytes);
+        m_timings.record(QStringLiteral("decompress"), state->decompression, data.size());
+
+        consumer(data);
+    });
+}
+
+} // QMediathekView
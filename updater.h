@@ -0,0 +1,94 @@
+/*
+
+Copyright 2016 Adam Reichold
+
+This file is part of QMediathekView.
+
+QMediathekView is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+QMediathekView is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with QMediathekView.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef UPDATER_H
+#define UPDATER_H
+
+#include <QObject>
+
+class QNetworkAccessManager;
+
+namespace QMediathekView
+{
+
+class Settings;
+class Timings;
+class Database;
+
+// Fetches the mirror lists and the show list and feeds the latter into the database.
+class Updater : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Updater)
+
+public:
+    Updater(Settings& settings, Timings& timings, Database& database, QObject* parent = 0);
+    ~Updater();
+
+    enum Kind
+    {
+        Automatic,
+        Full,
+        Partial
+    };
+
+signals:
+    void startedMirrorsUpdate();
+    void completedMirrorsUpdate();
+    void failedToUpdateMirrors(const QString& error);
+
+    void startedDatabaseUpdate();
+    void completedDatabaseUpdate();
+    void failedToUpdateDatabase(const QString& error);
+
+public:
+    // Updates the mirror lists and then the database, but each only if it is outdated.
+    void checkUpdateMirrors();
+    void checkUpdateDatabase();
+
+    void updateMirrors();
+    void updateDatabase(const Kind kind = Automatic);
+
+    // Updates the database unconditionally, fetching the mirror lists first if there are none yet.
+    void update(const Kind kind);
+
+private:
+    template< typename Continuation >
+    void fetchMirrors(const Continuation& continuation);
+
+    template< typename Consumer >
+    void downloadMirrors(const QString& url, const Consumer& consumer);
+
+    template< typename Consumer >
+    void downloadDatabase(const QString& url, const Consumer& consumer);
+
+private:
+    Settings& m_settings;
+    Timings& m_timings;
+    Database& m_database;
+
+    QNetworkAccessManager* m_networkManager;
+
+};
+
+} // QMediathekView
+
+#endif // UPDATER_H